@@ -0,0 +1,153 @@
+/**
+ * connect4.cpp
+ * Purpose: Implementation of the C interface to the Connect 4 solver.
+ *
+ * @author Yuta Nagano
+ * @version 1.1.0
+ */
+
+#include <new>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <stdexcept>
+#include "connect4.h"
+#include "../position/position.hpp"
+#include "../engine/engine.hpp"
+
+using namespace std;
+
+struct c4_solver {
+	Engine engine;
+
+	c4_solver(size_t table_size, bool huge_pages) : engine(table_size, huge_pages) {}
+};
+
+/**
+ * Build the position reached by a move string, checking every move (unlike
+ * the Position constructor, which only asserts that columns are not full).
+ * @return false if a move is not playable, or the game is already over
+ */
+static bool parse_moves(const char* moves, Position& P) {
+	P = Position();
+	for (const char* c = moves; *c; c++) {
+		int col = *c - '1';
+		if (col < 0 || col >= Position::WIDTH || !P.can_play(col) || P.is_winning_move(col)) return false;
+		P.play(col);
+	}
+	return P.get_moves() < Position::WIDTH * Position::HEIGHT;
+}
+
+/**
+ * Check that a position rebuilt from a key is still in play: the board is not
+ * full, and neither player has four in a row already.
+ */
+static bool in_play(const Position& P) {
+	if (P.get_moves() >= Position::WIDTH * Position::HEIGHT) return false;
+
+	// Directions to look for lines in: horizontal, vertical and both diagonals
+	const int directions[4][2] = {{1, 0}, {0, 1}, {1, 1}, {1, -1}};
+
+	for (int col = 0; col < Position::WIDTH; col++) {
+		for (int row = 0; row < Position::HEIGHT; row++) {
+			int piece = P.get_board(col, row);
+			if (piece == 0) continue;
+			for (const auto& d : directions) {
+				int n = 1;
+				while (n < 4) {
+					int c = col + n * d[0], r = row + n * d[1];
+					if (c < 0 || c >= Position::WIDTH || r < 0 || r >= Position::HEIGHT) break;
+					if (P.get_board(c, r) != piece) break;
+					n++;
+				}
+				if (n == 4) return false;
+			}
+		}
+	}
+
+	return true;
+}
+
+extern "C" {
+
+c4_status c4_solver_create(size_t table_mb, int huge_pages, c4_solver** solver) {
+	if (!solver) return C4_INVALID_ARGUMENT;
+	*solver = nullptr;
+	// Keep the size in bytes (and its rounding up to whole huge pages) from
+	// overflowing
+	if (table_mb > (SIZE_MAX >> 21)) return C4_INVALID_ARGUMENT;
+	try {
+		*solver = new c4_solver(table_mb << 20, huge_pages != 0);
+		return C4_OK;
+	}
+	catch (const bad_alloc&) {
+		return C4_OUT_OF_MEMORY;
+	}
+}
+
+void c4_solver_destroy(c4_solver* solver) {
+	delete solver;
+}
+
+c4_status c4_position_key(const char* moves, uint64_t* key) {
+	if (!moves || !key) return C4_INVALID_ARGUMENT;
+	Position P;
+	if (!parse_moves(moves, P)) return C4_INVALID_POSITION;
+	*key = P.get_key();
+	return C4_OK;
+}
+
+c4_status c4_solve(c4_solver* solver, const char* moves, int* score) {
+	if (!solver || !moves || !score) return C4_INVALID_ARGUMENT;
+	Position P;
+	if (!parse_moves(moves, P)) return C4_INVALID_POSITION;
+	int counter = 0;
+	*score = solver->engine.solve(P, counter);
+	return C4_OK;
+}
+
+c4_status c4_solve_key(c4_solver* solver, uint64_t key, int* score) {
+	if (!solver || !score) return C4_INVALID_ARGUMENT;
+	try {
+		Position P(key);
+		if (!in_play(P)) return C4_INVALID_POSITION;
+		int counter = 0;
+		*score = solver->engine.solve(P, counter);
+		return C4_OK;
+	}
+	catch (const runtime_error&) {
+		return C4_INVALID_POSITION;
+	}
+}
+
+c4_status c4_analyse(c4_solver* solver, const char* moves, c4_analysis* analysis) {
+	if (!solver || !moves || !analysis) return C4_INVALID_ARGUMENT;
+	Position P;
+	if (!parse_moves(moves, P)) return C4_INVALID_POSITION;
+
+	try {
+		int counter = 0;
+		analysis->score = solver->engine.solve(P, counter);
+		analysis->nodes = counter;
+
+		vector<int> pv = solver->engine.get_principal_variation();
+		for (size_t i = 0; i < pv.size(); i++) analysis->pv[i] = char('1' + pv[i]);
+		analysis->pv[pv.size()] = '\0';
+		analysis->best_move = pv.empty() ? 0 : pv[0] + 1;
+		return C4_OK;
+	}
+	catch (const bad_alloc&) {
+		return C4_OUT_OF_MEMORY;
+	}
+}
+
+c4_status c4_solve_batch(c4_solver* solver, const char* const* moves, size_t count, int* scores) {
+	if (!solver || (count && (!moves || !scores))) return C4_INVALID_ARGUMENT;
+	for (size_t i = 0; i < count; i++) {
+		c4_status status = c4_solve(solver, moves[i], &scores[i]);
+		if (status != C4_OK) return status;
+	}
+	return C4_OK;
+}
+
+}
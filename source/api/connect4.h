@@ -0,0 +1,104 @@
+/*
+ * connect4.h
+ * Purpose: C interface to the Connect 4 solver, for embedding it in other
+ * programs without going through the solver executable.
+ *
+ * A solver handle owns an engine and its transposition table, which stay warm
+ * between calls: solving related positions with the same handle (e.g. the
+ * successive positions of a game) gets faster as the table fills up. A handle
+ * must not be used by several threads at once; create one handle per thread
+ * instead.
+ *
+ * Positions are given either as move strings, in the same 1-indexed notation
+ * as the solver's input (e.g. "4453"), or as keys (see c4_position_key()).
+ * Scores follow the solver's convention: 0 for a draw, positive if the player
+ * to move wins (the sooner, the higher), negative if they lose.
+ *
+ * @author Yuta Nagano
+ * @version 1.1.0
+ */
+
+#ifndef CONNECT4_HEADER
+#define CONNECT4_HEADER
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Board size, and the longest possible principal variation */
+#define C4_WIDTH 7
+#define C4_HEIGHT 6
+#define C4_MAX_MOVES (C4_WIDTH * C4_HEIGHT)
+
+typedef enum {
+	C4_OK = 0,
+	/* A null handle or output pointer was passed */
+	C4_INVALID_ARGUMENT = 1,
+	/* The moves or key do not describe a game still in play */
+	C4_INVALID_POSITION = 2,
+	/* Memory for the solver or its results could not be allocated */
+	C4_OUT_OF_MEMORY = 3
+} c4_status;
+
+typedef struct c4_solver c4_solver;
+
+typedef struct {
+	/* Exact score of the position */
+	int score;
+	/* Best column to play (1-indexed) */
+	int best_move;
+	/* Principal variation, to the end of the game, as a null-terminated move
+	 * string */
+	char pv[C4_MAX_MOVES + 1];
+	/* Number of positions explored by the search that found all of the
+	 * above */
+	unsigned long long nodes;
+} c4_analysis;
+
+/*
+ * Create a solver using table_mb megabytes for its transposition table, on
+ * huge pages if huge_pages is non-zero and the system has some to give, and
+ * store it in *solver. Returns C4_INVALID_ARGUMENT if solver is NULL or
+ * table_mb is too large to be addressed, and C4_OUT_OF_MEMORY if the table
+ * could not be allocated; *solver is set to NULL on failure.
+ */
+c4_status c4_solver_create(size_t table_mb, int huge_pages, c4_solver** solver);
+
+/*
+ * Free a solver and its table. Passing NULL does nothing.
+ */
+void c4_solver_destroy(c4_solver* solver);
+
+/*
+ * Compute the key of the position reached by a move string.
+ */
+c4_status c4_position_key(const char* moves, uint64_t* key);
+
+/*
+ * Solve a position given as a move string or as a key.
+ */
+c4_status c4_solve(c4_solver* solver, const char* moves, int* score);
+c4_status c4_solve_key(c4_solver* solver, uint64_t key, int* score);
+
+/*
+ * Solve a position and also give its best move and principal variation, all
+ * from a single search. Returns C4_OUT_OF_MEMORY if the principal variation
+ * could not be allocated.
+ */
+c4_status c4_analyse(c4_solver* solver, const char* moves, c4_analysis* analysis);
+
+/*
+ * Solve count positions given as move strings, writing their scores to
+ * scores[0..count). Stops at the first invalid position and returns
+ * C4_INVALID_POSITION, with the scores before it filled in.
+ */
+c4_status c4_solve_batch(c4_solver* solver, const char* const* moves, size_t count, int* scores);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,97 @@
+/*
+ * connect4_tester.c
+ * Purpose: Unit test for the C interface to the solver. Written in C to make
+ * sure the interface can be used from C.
+ *
+ * @author Yuta Nagano
+ * @version 1.1.0
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include "connect4.h"
+
+static int fail(const char* msg) {
+	printf("Test failed: %s\n", msg);
+	return 1;
+}
+
+int main(void) {
+	int score, scores[3];
+	uint64_t key;
+	c4_analysis analysis;
+	const char* batch[3] = {"2252576253462244111563365343671351441", "7422341735647741166133573473242566", "23163416124767223154467471272416755633"};
+	const int expected[3] = {-1, 1, 0};
+
+	c4_solver* solver;
+
+	/* Tables too large to address, and missing output pointers, should be
+	 * reported rather than allocated */
+	if (c4_solver_create(SIZE_MAX, 0, &solver) != C4_INVALID_ARGUMENT || solver != NULL || \
+			c4_solver_create(16, 0, NULL) != C4_INVALID_ARGUMENT) {
+		return fail("c4_solver_create() accepted invalid arguments.");
+	}
+
+	/* The largest table that can be asked for cannot be allocated */
+	if (c4_solver_create(SIZE_MAX >> 21, 0, &solver) != C4_OUT_OF_MEMORY || solver != NULL) {
+		return fail("c4_solver_create() did not report running out of memory.");
+	}
+
+	if (c4_solver_create(16, 0, &solver) != C4_OK || !solver) return fail("c4_solver_create() failed.");
+
+	/* Positions taken from test_sets/Test_L3_R1 */
+	if (c4_solve(solver, batch[0], &score) != C4_OK || score != expected[0]) {
+		c4_solver_destroy(solver);
+		return fail("c4_solve() returned a wrong score.");
+	}
+
+	if (c4_solve_batch(solver, batch, 3, scores) != C4_OK || memcmp(scores, expected, sizeof(expected))) {
+		c4_solver_destroy(solver);
+		return fail("c4_solve_batch() returned wrong scores.");
+	}
+
+	/* Solving by key should agree with solving by moves */
+	if (c4_position_key(batch[1], &key) != C4_OK || c4_solve_key(solver, key, &score) != C4_OK || score != expected[1]) {
+		c4_solver_destroy(solver);
+		return fail("c4_solve_key() returned a wrong score.");
+	}
+
+	/* The analysis should start its principal variation with the best move */
+	if (c4_analyse(solver, batch[1], &analysis) != C4_OK || analysis.score != expected[1] || \
+			analysis.best_move < 1 || analysis.pv[0] != '0' + analysis.best_move) {
+		c4_solver_destroy(solver);
+		return fail("c4_analyse() returned a bad analysis.");
+	}
+
+	/* The principal variation should stop at the end of the game, both for an
+	 * immediate win and for a forced loss */
+	if (c4_analyse(solver, "44532312566", &analysis) != C4_OK || analysis.score != 16 || \
+			strcmp(analysis.pv, "1") != 0) {
+		c4_solver_destroy(solver);
+		return fail("c4_analyse() continued a won game after an immediate win.");
+	}
+
+	if (c4_analyse(solver, "44532312", &analysis) != C4_OK || analysis.score != -17 || \
+			strlen(analysis.pv) != 2) {
+		c4_solver_destroy(solver);
+		return fail("c4_analyse() continued a won game after a forced loss.");
+	}
+
+	/* Invalid positions and arguments should be reported, not solved:
+	 * a bad column, an overfull column, and a game that is already won */
+	if (c4_solve(solver, "48", &score) != C4_INVALID_POSITION || \
+			c4_solve(solver, "1111111", &score) != C4_INVALID_POSITION || \
+			c4_solve(solver, "1212121", &score) != C4_INVALID_POSITION || \
+			c4_solve_key(solver, 0, &score) != C4_INVALID_POSITION || \
+			c4_solve(solver, NULL, &score) != C4_INVALID_ARGUMENT || \
+			c4_solve(NULL, "44", &score) != C4_INVALID_ARGUMENT) {
+		c4_solver_destroy(solver);
+		return fail("Invalid input was not reported.");
+	}
+
+	c4_solver_destroy(solver);
+
+	/* If no errors have been found, test passed! */
+	printf("Test passed!\n");
+	return 0;
+}
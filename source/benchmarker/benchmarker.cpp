@@ -5,6 +5,13 @@
 				- standard input: one position per line (see below for position notation)
 				- standard output: space separated position, score, number of explored
 				  nodes, computation time in microseconds.
+				Pass --perf (after the two paths) if the solver also output hardware
+				performance counters (see solver.cpp's --perf option): their means
+				per position are then reported as well.
+				Pass --parallel N to validate very large files with N threads (0 for
+				one per core): both files are memory mapped and split into chunks of
+				whole lines, which are validated in parallel, and every mismatch is
+				reported with its line number instead of only the first one.
 	
 	Position notation: A string of numbers corresponding to the played columns.
 	E.g. 4453:
@@ -18,21 +25,100 @@
 	Created while following Pascal Pons' tutorial at blog.gamesolver.org/solving-connect-four
 	
 	@author Yuta Nagano
-	@version 1.1.0
+	@version 1.3.1
 */
 
 #include <iostream>
 #include <fstream>
 #include <string>
 #include <sstream>
+#include <vector>
+#include <thread>
+#include <algorithm>
+#include <charconv>
+#include <cstring>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
 
 using namespace std;
 
+/**
+ * Number and names of the hardware performance counter columns that follow the
+ * computation time in the output of a solver run with --perf.
+ */
+const int N_PERF_COUNTERS = 5;
+const string PERF_NAMES[N_PERF_COUNTERS] = {"cycles", "instructions", "branch misses", "L1 data cache misses", "last level cache misses"};
+
+/**
+ * Running sums of the performance counters. Each counter is summed over the
+ * lines it is available on, for its mean per position. The ratios to the
+ * instruction count are taken from separate sums over the lines on which both
+ * that counter and the instruction count are available.
+ */
+struct PerfSums {
+	unsigned long long c[N_PERF_COUNTERS] = {0}, n[N_PERF_COUNTERS] = {0};
+	unsigned long long c_paired[N_PERF_COUNTERS] = {0}, instructions_paired[N_PERF_COUNTERS] = {0};
+
+	/**
+	 * Add the counters of one line.
+	 *
+	 * @param value the counter values on the line.
+	 * @param available whether each counter was available on the line.
+	 */
+	void add(const unsigned long long value[], const bool available[]) {
+		for (int i = 0; i < N_PERF_COUNTERS; i++) {
+			if (!available[i]) continue;
+			c[i] += value[i];
+			n[i]++;
+			if (available[1]) {
+				c_paired[i] += value[i];
+				instructions_paired[i] += value[1];
+			}
+		}
+	}
+
+	/**
+	 * Add the sums gathered over other lines.
+	 */
+	void add(const PerfSums& other) {
+		for (int i = 0; i < N_PERF_COUNTERS; i++) {
+			c[i] += other.c[i];
+			n[i] += other.n[i];
+			c_paired[i] += other.c_paired[i];
+			instructions_paired[i] += other.instructions_paired[i];
+		}
+	}
+};
+
+/**
+ * A line on which the output does not match the dataset, and the kind of
+ * mismatch, using compare_files()'s error codes: 1 for missing lines (from
+ * this line on), 2 for a mismatched position and 3 for a mismatched score.
+ */
+struct Mismatch {
+	unsigned long long line;
+	int code;
+};
+
+/**
+ * A read-only memory mapped file.
+ */
+struct MappedFile {
+	const char* data = nullptr;
+	size_t size = 0;
+};
+
 int run(int argc, char* argv[]);
 int test(int argc, char* argv[]);
 int open_files(int argc, char* argv[], ifstream& dataset, ifstream& output, bool verbose = true);
 int open_file(string fname, ifstream& stream, bool verbose = true);
-int compare_files(ifstream& dataset, ifstream& output, float& mean_explored_nodes, float& mean_time_mics, bool verbose = true);
+int compare_files(ifstream& dataset, ifstream& output, float& mean_explored_nodes, float& mean_time_mics, bool verbose = true, double* mean_perf = nullptr);
+void summarise(unsigned long long lines, unsigned long long c_explored_nodes, unsigned long long c_time_mics, const PerfSums& perf, float& mean_explored_nodes, float& mean_time_mics, bool verbose, double* mean_perf);
+int map_file(string fname, MappedFile& file, bool verbose = true);
+void unmap_file(MappedFile& file);
+int compare_files_parallel(string dataset_fname, string output_fname, int threads, float& mean_explored_nodes, float& mean_time_mics, bool verbose = true, double* mean_perf = nullptr, vector<Mismatch>* mismatches = nullptr);
 
 int main(int argc, char* argv[]) {
 	//test(argc, argv);
@@ -45,12 +131,33 @@ int run(int argc, char* argv[]) {
 	// Declare some fstreams to open the relevant files in
 	ifstream dataset, output;
 	float mean_explored_nodes, mean_time_mics;
+	double mean_perf[N_PERF_COUNTERS];
+
+	// Read any options following the two paths
+	bool perf = false;
+	int threads = -1;
+	for (int i = 3; i < argc; i++) {
+		string arg = argv[i];
+		if (arg == "--perf") perf = true;
+		else if (arg == "--parallel" && i + 1 < argc) threads = stoi(argv[++i]);
+		else {
+			cout << "Error: unrecognised option " << arg << endl;
+			return 1;
+		}
+	}
+	argc = min(argc, 3);
+
+	if (threads >= 0) {
+		if (argc != 3) return open_files(argc, argv, dataset, output);
+		if (threads == 0) threads = max(1u, thread::hardware_concurrency());
+		return compare_files_parallel(argv[1], argv[2], threads, mean_explored_nodes, mean_time_mics, true, perf ? mean_perf : nullptr) ? 1 : 0;
+	}
 
 	// Try to open the dataset and output files, report any errors
 	if (open_files(argc, argv, dataset, output)) return 1;
 	
 	// Go through each line on both files and analyse, report any errors
-	if (compare_files(dataset, output, mean_explored_nodes, mean_time_mics)) return 1;
+	if (compare_files(dataset, output, mean_explored_nodes, mean_time_mics, true, perf ? mean_perf : nullptr)) return 1;
 
 	// Close fstreams now that we are done reading
 	dataset.close();
@@ -131,6 +238,26 @@ int test(int argc, char* argv[]) {
 	dataset.clear();
 	dataset.seekg(0);
 
+	// Next, open the "o_perf" output file which has performance counter columns
+	// Ensure no mismatches found, and validate the counter means (counters
+	// printed as "-" are left out, and -1 means a counter was never available)
+	if (open_file("benchmarker_test_files/o_perf",output)) return 1;
+	double mean_perf[N_PERF_COUNTERS];
+	if (compare_files(dataset,output,mean_explored_nodes,mean_time_mics,false,mean_perf)) {
+		cout << "Test failed: found mismatch in output with performance counters." << endl;
+		return 1;
+	}
+	if (mean_perf[0] != 350 || mean_perf[1] != 35 || mean_perf[2] != 3.5 || \
+			mean_perf[3] != 10 || mean_perf[4] != -1) {
+		cout << "Test failed: bad mean performance counters." << endl;
+		return 1;
+	}
+
+	// Reset buffers
+	output.close();
+	dataset.clear();
+	dataset.seekg(0);
+
 	// Finally, open the "o_wrong_position" file which should have a position mismatch
 	// Ensure position mismatch found
 	if (open_file("benchmarker_test_files/o_wrong_position",output)) return 1;
@@ -143,6 +270,36 @@ int test(int argc, char* argv[]) {
 	dataset.close();
 	output.close();
 
+	// Run the same checks in parallel mode, with more threads than some
+	// chunks have lines
+	if (compare_files_parallel("benchmarker_test_files/d","benchmarker_test_files/o_identical",4,mean_explored_nodes,mean_time_mics,false) || \
+			mean_explored_nodes != 58 || mean_time_mics != 313) {
+		cout << "Test failed: parallel mode found a mismatch or bad metrics in identical output." << endl;
+		return 1;
+	}
+	if (compare_files_parallel("benchmarker_test_files/d","benchmarker_test_files/o_bad_score",4,mean_explored_nodes,mean_time_mics,false) != 3 || \
+			compare_files_parallel("benchmarker_test_files/d","benchmarker_test_files/o_missing_line",4,mean_explored_nodes,mean_time_mics,false) != 1 || \
+			compare_files_parallel("benchmarker_test_files/d","benchmarker_test_files/o_weaksolver",4,mean_explored_nodes,mean_time_mics,false) != 0 || \
+			compare_files_parallel("benchmarker_test_files/d","benchmarker_test_files/o_wrong_position",4,mean_explored_nodes,mean_time_mics,false) != 2) {
+		cout << "Test failed: parallel mode did not match serial mode." << endl;
+		return 1;
+	}
+	if (compare_files_parallel("benchmarker_test_files/d","benchmarker_test_files/o_perf",3,mean_explored_nodes,mean_time_mics,false,mean_perf) || \
+			mean_perf[0] != 350 || mean_perf[3] != 10 || mean_perf[4] != -1) {
+		cout << "Test failed: parallel mode returned bad mean performance counters." << endl;
+		return 1;
+	}
+
+	// The "o_many_mismatches" output file has a position mismatch on line 2
+	// and a score mismatch on line 5: ensure both are reported
+	vector<Mismatch> mismatches;
+	if (compare_files_parallel("benchmarker_test_files/d","benchmarker_test_files/o_many_mismatches",2,mean_explored_nodes,mean_time_mics,false,nullptr,&mismatches) != 2 || \
+			mismatches.size() != 2 || mismatches[0].line != 2 || mismatches[0].code != 2 || \
+			mismatches[1].line != 5 || mismatches[1].code != 3) {
+		cout << "Test failed: parallel mode did not report every mismatch." << endl;
+		return 1;
+	}
+
 	cout << "Test passed!" << endl;
 
 	return 0;
@@ -181,10 +338,11 @@ int open_file(string fname, ifstream& stream, bool verbose /*=true*/) {
 	return 0;
 }
 
-int compare_files(ifstream& dataset, ifstream& output, float& mean_explored_nodes, float& mean_time_mics, bool verbose /*=true*/) {
+int compare_files(ifstream& dataset, ifstream& output, float& mean_explored_nodes, float& mean_time_mics, bool verbose /*=true*/, double* mean_perf /*=nullptr*/) {
 	// Declare necessary variables
 	unsigned int line_num = 1;
 	unsigned long long c_explored_nodes = 0, c_time_mics = 0;
+	PerfSums perf;
 	string temp, dataset_token, output_token;
 	istringstream dataset_ss, output_ss;
 
@@ -234,23 +392,333 @@ int compare_files(ifstream& dataset, ifstream& output, float& mean_explored_node
 		// Look at the third and fourth tokens on the output file (# explored nodes and
 		// computation time in microseconds) and increment the respective counters
 		output_ss >> output_token;
-		c_explored_nodes += stoi(output_token);
+		c_explored_nodes += stoull(output_token);
 		output_ss >> output_token;
-		c_time_mics += stoi(output_token);
+		c_time_mics += stoull(output_token);
+
+		// If asked, look at the performance counter tokens that follow, leaving
+		// out any counter that was unavailable ("-")
+		if (mean_perf) {
+			unsigned long long value[N_PERF_COUNTERS] = {0};
+			bool available[N_PERF_COUNTERS] = {false};
+			for (int i = 0; i < N_PERF_COUNTERS; i++) {
+				if (!(output_ss >> output_token) || output_token == "-") continue;
+				value[i] = stoull(output_token);
+				available[i] = true;
+			}
+			perf.add(value, available);
+		}
 
 		line_num++;
 	}
 
+	if (verbose) cout << "Solver output validated: no mismatches found." << endl;
+
+	summarise(line_num - 1, c_explored_nodes, c_time_mics, perf, mean_explored_nodes, mean_time_mics, verbose, mean_perf);
+
+	return 0;
+}
+
+void summarise(unsigned long long lines, unsigned long long c_explored_nodes, unsigned long long c_time_mics, const PerfSums& perf, float& mean_explored_nodes, float& mean_time_mics, bool verbose, double* mean_perf) {
 	// Calculate the mean computation time and mean number of positions explored
-	mean_explored_nodes = float(c_explored_nodes) / (line_num - 1);
-	mean_time_mics = float(c_time_mics) / (line_num - 1);
+	mean_explored_nodes = float(c_explored_nodes) / lines;
+	mean_time_mics = float(c_time_mics) / lines;
 
 	if (verbose) {
-		cout << "Solver output validated: no mismatches found." << endl;
 		cout << "Benchmarking metrics:" << endl;
 		cout << "Mean # of nodes explored per position: " << mean_explored_nodes << endl;
 		cout << "Mean time for computation per position (us): " << mean_time_mics << endl;
 	}
 
+	if (mean_perf) {
+		for (int i = 0; i < N_PERF_COUNTERS; i++)
+			mean_perf[i] = perf.n[i] ? double(perf.c[i]) / perf.n[i] : -1;
+
+		if (verbose) {
+			for (int i = 0; i < N_PERF_COUNTERS; i++) {
+				cout << "Mean # of " << PERF_NAMES[i] << " per position: ";
+				if (perf.n[i]) cout << mean_perf[i] << endl;
+				else cout << "unavailable" << endl;
+			}
+			// Instructions per cycle and misses per thousand instructions tell
+			// whether a solver is bound by branches or by memory, and only
+			// use the lines on which both counters of a ratio are available
+			if (perf.c_paired[0]) {
+				cout << "Instructions per cycle: " << double(perf.instructions_paired[0]) / perf.c_paired[0] << endl;
+			}
+			for (int i = 2; i < N_PERF_COUNTERS; i++) {
+				if (perf.instructions_paired[i]) {
+					cout << "Mean # of " << PERF_NAMES[i] << " per 1000 instructions: " << \
+						1000.0 * perf.c_paired[i] / perf.instructions_paired[i] << endl;
+				}
+			}
+		}
+	}
+}
+
+int map_file(string fname, MappedFile& file, bool verbose /*=true*/) {
+	int fd = open(fname.c_str(), O_RDONLY);
+	struct stat info;
+	if (fd < 0 || fstat(fd, &info) != 0) {
+		if (fd >= 0) close(fd);
+		if (verbose) {
+			cout << "Error: bad path supplied.\n";
+		}
+		return 1;
+	}
+
+	// Empty files cannot be mapped, but there is nothing to read anyway
+	file.size = info.st_size;
+	file.data = nullptr;
+	if (file.size > 0) {
+		void* data = mmap(nullptr, file.size, PROT_READ, MAP_PRIVATE, fd, 0);
+		if (data == MAP_FAILED) {
+			close(fd);
+			if (verbose) {
+				cout << "Error: could not map " << fname << endl;
+			}
+			return 1;
+		}
+		madvise(data, file.size, MADV_SEQUENTIAL);
+		file.data = static_cast<const char*>(data);
+	}
+
+	close(fd);
+	return 0;
+}
+
+void unmap_file(MappedFile& file) {
+	if (file.data) munmap(const_cast<char*>(file.data), file.size);
+	file.data = nullptr;
+	file.size = 0;
+}
+
+/**
+ * Split [begin, end) into (at most) parts pieces of roughly equal size, each
+ * ending just after a newline (apart from the last one).
+ * @return the parts+1 boundaries of the pieces
+ */
+static vector<const char*> split_at_lines(const char* begin, const char* end, int parts) {
+	vector<const char*> bounds{begin};
+	for (int i = 1; i < parts; i++) {
+		const char* p = max(bounds.back(), begin + (end - begin) * i / parts);
+		const char* newline = p < end ? static_cast<const char*>(memchr(p, '\n', end - p)) : nullptr;
+		bounds.push_back(newline ? newline + 1 : end);
+	}
+	bounds.push_back(end);
+	return bounds;
+}
+
+/**
+ * @return the number of newlines in [begin, end)
+ */
+static unsigned long long count_newlines(const char* begin, const char* end) {
+	unsigned long long n = 0;
+	while (begin < end && (begin = static_cast<const char*>(memchr(begin, '\n', end - begin)))) {
+		n++;
+		begin++;
+	}
+	return n;
+}
+
+/**
+ * Read the next whitespace separated token of a line.
+ * @return false if there are no tokens left
+ */
+static bool next_token(const char*& p, const char* end, const char*& token, size_t& length) {
+	while (p < end && (*p == ' ' || *p == '\t' || *p == '\r')) p++;
+	if (p == end) return false;
+	token = p;
+	while (p < end && *p != ' ' && *p != '\t' && *p != '\r') p++;
+	length = p - token;
+	return true;
+}
+
+/**
+ * @return the value of a numerical token (0 if it is not a number)
+ */
+static long long parse_token(const char* token, size_t length) {
+	long long value = 0;
+	from_chars(token, token + length, value);
+	return value;
+}
+
+/**
+ * A range of dataset lines validated by one thread, along with its results.
+ */
+struct Chunk {
+	const char *dataset_begin, *dataset_end, *output_begin, *output_end;
+	unsigned long long first_line;
+
+	unsigned long long lines = 0, c_explored_nodes = 0, c_time_mics = 0;
+	PerfSums perf;
+	vector<Mismatch> mismatches;
+};
+
+/**
+ * Validate the dataset lines of a chunk against the output lines starting at
+ * output_begin, in the same way as compare_files(), but carrying on past
+ * mismatches.
+ */
+static void compare_chunk(Chunk& chunk, bool perf) {
+	const char* d = chunk.dataset_begin;
+	const char* o = chunk.output_begin;
+	unsigned long long line_num = chunk.first_line;
+
+	for (; d < chunk.dataset_end; line_num++) {
+		const char* d_line_end = static_cast<const char*>(memchr(d, '\n', chunk.dataset_end - d));
+		if (!d_line_end) d_line_end = chunk.dataset_end;
+
+		// If output file has fewer lines than dataset, report error
+		if (o >= chunk.output_end) {
+			chunk.mismatches.push_back({line_num, 1});
+			return;
+		}
+		const char* o_line_end = static_cast<const char*>(memchr(o, '\n', chunk.output_end - o));
+		if (!o_line_end) o_line_end = chunk.output_end;
+
+		const char *d_token = d, *o_token = o;
+		size_t d_length = 0, o_length = 0;
+		chunk.lines++;
+
+		// Look at the first token (position), ensure they are similar
+		next_token(d, d_line_end, d_token, d_length);
+		next_token(o, o_line_end, o_token, o_length);
+		if (d_length != o_length || memcmp(d_token, o_token, d_length)) {
+			chunk.mismatches.push_back({line_num, 2});
+		}
+		else {
+			// Look at the second token (score), ensure they are similar
+			// (accounting for weak/strong solvers)
+			next_token(d, d_line_end, d_token, d_length);
+			next_token(o, o_line_end, o_token, o_length);
+			if (d_length != o_length || memcmp(d_token, o_token, d_length)) {
+				long long dataset_score = parse_token(d_token, d_length);
+				long long output_score = parse_token(o_token, o_length);
+				if (dataset_score * output_score <= 0 || llabs(output_score) != 1) {
+					chunk.mismatches.push_back({line_num, 3});
+				}
+			}
+
+			// Add up the explored nodes, computation time and counters
+			if (next_token(o, o_line_end, o_token, o_length))
+				chunk.c_explored_nodes += parse_token(o_token, o_length);
+			if (next_token(o, o_line_end, o_token, o_length))
+				chunk.c_time_mics += parse_token(o_token, o_length);
+			if (perf) {
+				unsigned long long value[N_PERF_COUNTERS] = {0};
+				bool available[N_PERF_COUNTERS] = {false};
+				for (int i = 0; i < N_PERF_COUNTERS; i++) {
+					if (!next_token(o, o_line_end, o_token, o_length)) break;
+					if (o_length == 1 && *o_token == '-') continue;
+					value[i] = parse_token(o_token, o_length);
+					available[i] = true;
+				}
+				chunk.perf.add(value, available);
+			}
+		}
+
+		d = d_line_end < chunk.dataset_end ? d_line_end + 1 : d_line_end;
+		o = o_line_end < chunk.output_end ? o_line_end + 1 : o_line_end;
+	}
+}
+
+int compare_files_parallel(string dataset_fname, string output_fname, int threads, float& mean_explored_nodes, float& mean_time_mics, bool verbose /*=true*/, double* mean_perf /*=nullptr*/, vector<Mismatch>* mismatches /*=nullptr*/) {
+	MappedFile dataset, output;
+	if (map_file(dataset_fname, dataset, verbose)) return 1;
+	if (map_file(output_fname, output, verbose)) {
+		unmap_file(dataset);
+		return 1;
+	}
+	const char* dataset_end = dataset.data + dataset.size;
+	const char* output_end = output.data + output.size;
+
+	// Split both files into chunks of whole lines, and count the lines in
+	// every chunk in parallel
+	vector<const char*> dataset_bounds = split_at_lines(dataset.data, dataset_end, threads);
+	vector<const char*> output_bounds = split_at_lines(output.data, output_end, threads);
+	vector<unsigned long long> dataset_lines(threads), output_lines(threads);
+	vector<thread> workers;
+	for (int i = 0; i < threads; i++) {
+		workers.emplace_back([&, i]() {
+			dataset_lines[i] = count_newlines(dataset_bounds[i], dataset_bounds[i + 1]);
+			output_lines[i] = count_newlines(output_bounds[i], output_bounds[i + 1]);
+		});
+	}
+	for (thread& worker : workers) worker.join();
+	workers.clear();
+	// A last line without a newline is still a line
+	if (output.size > 0 && output_end[-1] != '\n') output_lines[threads - 1]++;
+
+	// Each dataset chunk starts at a known line: find where that line starts
+	// in the output, from the output chunk it falls in
+	vector<Chunk> chunks(threads);
+	unsigned long long line = 0;
+	int output_chunk = 0;
+	unsigned long long output_chunk_line = 0;
+	for (int i = 0; i < threads; i++) {
+		Chunk& chunk = chunks[i];
+		chunk.dataset_begin = dataset_bounds[i];
+		chunk.dataset_end = dataset_bounds[i + 1];
+		chunk.output_end = output_end;
+		chunk.first_line = line + 1;
+
+		while (output_chunk < threads && output_chunk_line + output_lines[output_chunk] <= line)
+			output_chunk_line += output_lines[output_chunk++];
+		if (output_chunk == threads) {
+			chunk.output_begin = output_end;
+		}
+		else {
+			const char* p = output_bounds[output_chunk];
+			for (unsigned long long skip = line - output_chunk_line; skip > 0; skip--)
+				p = static_cast<const char*>(memchr(p, '\n', output_end - p)) + 1;
+			chunk.output_begin = p;
+		}
+
+		line += dataset_lines[i];
+	}
+
+	// Validate the chunks in parallel
+	for (int i = 0; i < threads; i++) {
+		workers.emplace_back(compare_chunk, ref(chunks[i]), mean_perf != nullptr);
+	}
+	for (thread& worker : workers) worker.join();
+
+	unmap_file(dataset);
+	unmap_file(output);
+
+	// Gather the results, in line order. Missing lines are only reported
+	// once, from the first missing line.
+	vector<Mismatch> found;
+	unsigned long long lines = 0, c_explored_nodes = 0, c_time_mics = 0;
+	PerfSums perf;
+	for (const Chunk& chunk : chunks) {
+		for (const Mismatch& mismatch : chunk.mismatches) {
+			if (mismatch.code == 1 && !found.empty() && found.back().code == 1) continue;
+			found.push_back(mismatch);
+		}
+		lines += chunk.lines;
+		c_explored_nodes += chunk.c_explored_nodes;
+		c_time_mics += chunk.c_time_mics;
+		perf.add(chunk.perf);
+	}
+	if (mismatches) *mismatches = found;
+
+	if (!found.empty()) {
+		if (verbose) {
+			for (const Mismatch& mismatch : found) {
+				if (mismatch.code == 1) cout << "Error: missing lines in output file " << mismatch.line << endl;
+				else if (mismatch.code == 2) cout << "Error: mismatched position on line " << mismatch.line << endl;
+				else cout << "Error: mismatched score on line " << mismatch.line << endl;
+			}
+			cout << "Found " << found.size() << " mismatches." << endl;
+		}
+		return found.front().code;
+	}
+
+	if (verbose) cout << "Solver output validated: no mismatches found." << endl;
+
+	summarise(lines, c_explored_nodes, c_time_mics, perf, mean_explored_nodes, mean_time_mics, verbose, mean_perf);
+
 	return 0;
 }
@@ -0,0 +1,335 @@
+/**
+ * engine.cpp
+ * Purpose: Implementation for a class that searches Connect 4 positions for
+ * their exact scores.
+ *
+ * @author Yuta Nagano
+ * @version 1.6.0
+ */
+
+#include <climits>
+#include <algorithm>
+#include "engine.hpp"
+
+using namespace std;
+
+/**
+ * Ordering scores given to the killer moves of a ply, above any history score.
+ */
+static const int KILLER_SCORE[SearchContext::KILLERS] = {INT_MAX, INT_MAX - 1};
+
+/**
+ * History scores are halved once any of them goes over this limit, so that
+ * they cannot overflow and recent cutoffs weigh more than old ones.
+ */
+static const int HISTORY_LIMIT = 1 << 24;
+
+// SearchContext
+
+void SearchContext::clear() {
+	for (int i = 0; i < MAX_PLY; i++)
+		for (int j = 0; j < KILLERS; j++)
+			killers[i][j] = -1;
+	for (int p = 0; p < 2; p++)
+		for (int col = 0; col < Position::WIDTH; col++)
+			for (int row = 0; row < Position::HEIGHT; row++)
+				history[p][col][row] = 0;
+	for (int i = 0; i <= MAX_PLY; i++)
+		pv_length[i] = 0;
+	root_ply = 0;
+	position_counter = 0;
+	cutoffs = 0;
+	first_child_cutoffs = 0;
+}
+
+// Constructors
+
+Engine::Engine(size_t table_size, bool huge_pages) : table(table_size, huge_pages), stopped{false} {
+	// Initialise the values within the columnOrder array.
+	for (int i = 0; i < Position::WIDTH; i++)
+		columnOrder[i] = Position::WIDTH/2 + (i+1)/2 * (1-2*(i%2));
+	context.clear();
+}
+
+// Public methods
+
+int Engine::solve(const Position& P, int& position_counter) {
+	int baseScore = Position::WIDTH * Position::HEIGHT / 2;
+	// Start from fresh killers and history: what was learnt while solving an
+	// unrelated position tends to be worse advice than the static order
+	context.clear();
+	context.root_ply = P.get_moves();
+	int score = negamax(P, -baseScore, baseScore, context);
+	position_counter += context.position_counter;
+	return score;
+}
+
+vector<int> Engine::get_principal_variation() const {
+	int ply = context.root_ply;
+	return vector<int>(context.pv[ply], context.pv[ply] + context.pv_length[ply]);
+}
+
+bool Engine::reconstruct_variation(const Position& P, int score, vector<int>& pv) const {
+	pv.clear();
+	Position current(P);
+
+	while (current.get_moves() < Position::WIDTH * Position::HEIGHT) {
+		// An immediate win ends the line if it explains the score
+		int win = -1;
+		for (int i = 0; i < Position::WIDTH; i++) {
+			int col = columnOrder[i];
+			if (current.can_play(col) && current.is_winning_move(col)) {
+				win = col;
+				break;
+			}
+		}
+		if (win >= 0) {
+			if (score != (Position::WIDTH * Position::HEIGHT - int(current.get_moves()) + 1) / 2) return false;
+			pv.push_back(win);
+			return true;
+		}
+
+		// Otherwise a move is on the principal variation if its child is
+		// known to be worth no more than -score to the opponent: since score
+		// is exact, that child is then worth exactly -score
+		int next = -1;
+		for (int i = 0; i < Position::WIDTH && next < 0; i++) {
+			int col = columnOrder[i];
+			if (!current.can_play(col)) continue;
+			Position child(current);
+			child.play(col);
+			if (known_at_most(child, -score)) next = col;
+		}
+		if (next < 0) return false;
+
+		pv.push_back(next);
+		current.play(next);
+		score = -score;
+	}
+
+	return true;
+}
+
+int Engine::negamax(const Position& P, int alpha, int beta, SearchContext& context) {
+	// Unwind straight away if another thread has asked us to stop
+	if (stopped.load(memory_order_relaxed)) return 0;
+
+	// Increment the position counter as we are evaluating a new position
+	context.position_counter++;
+
+	// No principal variation is known from here yet
+	int ply = P.get_moves();
+	context.pv_length[ply] = 0;
+
+	// Check for a draw, and return 0 if the case
+	if (P.get_moves() == Position::WIDTH * Position::HEIGHT) return 0;
+
+	// Check if current player can win in the next move, and return appropriate
+	// score if the case
+	for (int i = 0; i < Position::WIDTH; i++) {
+		if (P.can_play(i) && P.is_winning_move(i)) {
+			context.pv[ply][0] = i;
+			context.pv_length[ply] = 1;
+			return (Position::WIDTH * Position::HEIGHT - P.get_moves() + 1) / 2;
+		}
+	}
+
+	// Otherwise, recursively evaluate future positions via negamax and use
+	// those evaluations to compute the value of the current position
+
+	// Gather what is known about the score before searching: minScore and
+	// maxScore are proven bounds, and the window is narrowed to them below.
+	// The window is always left one point wider than the bounds, so that a
+	// position whose score lies strictly inside the window (as every position
+	// on the principal variation does) keeps it strictly inside, and its best
+	// child does too: the search then follows the line to the end of the game
+	// instead of stopping where the score was already known.
+	int alphaOrig = alpha;
+
+	// Start from the worst possible score and the best possible one, given
+	// that we cannot win immediately
+	int minScore = -Position::WIDTH * Position::HEIGHT / 2;
+	int maxScore = (Position::WIDTH * Position::HEIGHT - P.get_moves() - 1) / 2;
+	// Prune exploration if the window is below the best possible score
+	if (alpha >= maxScore) return maxScore;
+
+	// Bound the score with the static threat analysis, which can settle
+	// the position outright (e.g. when no move avoids an immediate loss, or
+	// when neither side has a line left to complete)
+	int minBound, maxBound;
+	P.get_score_bounds(minBound, maxBound);
+	if (minBound >= beta) return minBound;
+	if (maxBound <= alpha) return maxBound;
+	minScore = max(minScore, minBound);
+	maxScore = min(maxScore, maxBound);
+
+	// Bound it with whatever we already know about this position. The
+	// caller prefetched its bucket, so it should be in cache by now.
+	uint64_t key = P.get_key();
+	int depth = Position::WIDTH * Position::HEIGHT - P.get_moves();
+	int cached;
+	switch (table.get(key, cached)) {
+		case TranspositionTable::EXACT:
+			if (cached <= alpha || cached >= beta) return cached;
+			minScore = maxScore = cached;
+			break;
+		case TranspositionTable::LOWER:
+			if (cached >= beta) return cached;
+			minScore = max(minScore, cached);
+			break;
+		case TranspositionTable::UPPER:
+			if (cached <= alpha) return cached;
+			maxScore = min(maxScore, cached);
+			break;
+		default:
+			break;
+	}
+
+	if (alpha < minScore - 1) alpha = minScore - 1;
+	if (beta > maxScore + 1) beta = maxScore + 1;
+
+	// Evaluate the scores of all possible next positions and keep the best one
+	int moves[Position::WIDTH];
+	int n_moves = order_moves(P, context, moves);
+	for (int i = 0; i < n_moves; i++) {
+		int move = moves[i];
+		// Create a copy of the curent position
+		Position P2(P);
+		// Use this copy to play the potential move, and start fetching its
+		// table bucket while the child checks for immediate wins
+		P2.play(move);
+		table.prefetch(P2.get_key());
+		// Evaluate the position (negative score because the "current player"
+		// in this position would be the opponent of the current player of
+		// the current position being evaluated. Notice also that the alpha
+		// and beta are inverted and fed in in the opposite order.)
+		int score = -negamax(P2, -beta, -alpha, context);
+		// A move raising alpha is the best found so far
+		if (score > alpha) update_pv(P, move, context);
+		// Prune the exploration if we find a move better than what our
+		// opponent will allow (beta), or as good as the position can be
+		// (maxScore, which makes the score exact), and remember the move that
+		// did it
+		if (score >= beta || score >= maxScore) {
+			context.cutoffs++;
+			if (i == 0) context.first_child_cutoffs++;
+			record_cutoff(P, move, context);
+			if (!is_stopped())
+				table.put(key, score, score >= maxScore ? TranspositionTable::EXACT : TranspositionTable::LOWER, depth);
+			return score;
+		}
+		// Reduce the [alpha:beta] window for subsequent exploration if we
+		// find current_alpha < score < beta.
+		if (score > alpha) alpha = score;
+	}
+
+	// Remember the result: it is exact if a child landed inside the original
+	// window, and only an upper bound otherwise
+	if (!is_stopped())
+		table.put(key, alpha, alpha > alphaOrig ? TranspositionTable::EXACT : TranspositionTable::UPPER, depth);
+
+	// Return the minimum guaranteed score
+	return alpha;
+}
+
+int Engine::get_column(int i) const {
+	return columnOrder[i];
+}
+
+void Engine::stop() {
+	stopped = true;
+}
+
+void Engine::resume() {
+	stopped = false;
+}
+
+bool Engine::is_stopped() const {
+	return stopped;
+}
+
+const SearchContext& Engine::get_context() const {
+	return context;
+}
+
+const TranspositionTable& Engine::get_table() const {
+	return table;
+}
+
+// Private methods
+
+void Engine::update_pv(const Position& P, int col, SearchContext& context) const {
+	int ply = P.get_moves();
+	int length = context.pv_length[ply + 1];
+	context.pv[ply][0] = col;
+	for (int i = 0; i < length; i++)
+		context.pv[ply][i + 1] = context.pv[ply + 1][i];
+	context.pv_length[ply] = length + 1;
+}
+
+bool Engine::known_at_most(const Position& P, int target) const {
+	if (P.get_moves() == Position::WIDTH * Position::HEIGHT) return 0 <= target;
+
+	// Positions settled by an immediate win or by the static threat analysis
+	// are never stored in the table, but the analysis bounds them anyway
+	int minBound, maxBound;
+	P.get_score_bounds(minBound, maxBound);
+	if (maxBound <= target) return true;
+
+	int cached;
+	TranspositionTable::Bound bound = table.get(P.get_key(), cached);
+	return (bound == TranspositionTable::EXACT || bound == TranspositionTable::UPPER) && cached <= target;
+}
+
+int Engine::order_moves(const Position& P, const SearchContext& context, int moves[Position::WIDTH]) const {
+	int player = P.get_moves() % 2;
+	const int* killers = context.killers[P.get_moves()];
+	int scores[Position::WIDTH];
+	int n = 0;
+
+	// Insertion sort on the ordering scores: there are at most WIDTH moves,
+	// and moves with equal scores stay in the static column order
+	for (int i = 0; i < Position::WIDTH; i++) {
+		int col = columnOrder[i];
+		if (!P.can_play(col)) continue;
+
+		int score = context.history[player][col][P.get_height(col)];
+		for (int k = 0; k < SearchContext::KILLERS; k++) {
+			if (killers[k] == col) {
+				score = KILLER_SCORE[k];
+				break;
+			}
+		}
+
+		int j = n++;
+		for (; j > 0 && scores[j-1] < score; j--) {
+			scores[j] = scores[j-1];
+			moves[j] = moves[j-1];
+		}
+		scores[j] = score;
+		moves[j] = col;
+	}
+
+	return n;
+}
+
+void Engine::record_cutoff(const Position& P, int col, SearchContext& context) const {
+	// Make col the most recent killer of this ply, shifting the others down
+	int* killers = context.killers[P.get_moves()];
+	if (killers[0] != col) {
+		for (int k = SearchContext::KILLERS - 1; k > 0; k--)
+			killers[k] = killers[k-1];
+		killers[0] = col;
+	}
+
+	// Cutoffs higher up the tree prune more, so weigh them more
+	int depth = Position::WIDTH * Position::HEIGHT - P.get_moves();
+	int& entry = context.history[P.get_moves() % 2][col][P.get_height(col)];
+	entry += depth * depth;
+	if (entry > HISTORY_LIMIT) {
+		for (int p = 0; p < 2; p++)
+			for (int c = 0; c < Position::WIDTH; c++)
+				for (int r = 0; r < Position::HEIGHT; r++)
+					context.history[p][c][r] /= 2;
+	}
+}
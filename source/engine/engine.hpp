@@ -0,0 +1,229 @@
+/**
+ * engine.hpp
+ * Purpose: A definition for a class that searches Connect 4 positions for
+ * their exact scores.
+ *
+ * @author Yuta Nagano
+ * @version 1.6.0
+ */
+
+#ifndef ENGINE_HEADER
+#define ENGINE_HEADER
+
+#include <atomic>
+#include <vector>
+#include "../position/position.hpp"
+#include "../transposition_table/transposition_table.hpp"
+
+/**
+ * Per-search state that is threaded through the recursion: the move ordering
+ * heuristics learnt from earlier cutoffs, the principal variation, and
+ * counters describing the search.
+ * It is allocated once per engine and cleared at the start of every search.
+ */
+struct SearchContext {
+	static const int MAX_PLY = Position::WIDTH * Position::HEIGHT;
+	static const int KILLERS = 2;
+
+	/**
+	 * Columns that most recently caused a beta cutoff at each ply (number of
+	 * moves played), most recent first, or -1 if there are none.
+	 */
+	int killers[MAX_PLY][KILLERS];
+
+	/**
+	 * Accumulated cutoff scores for each player (0 for the first player, 1
+	 * for the second) playing into each cell, indexed as [player][col][row].
+	 */
+	int history[2][Position::WIDTH][Position::HEIGHT];
+
+	/**
+	 * Triangular array of principal variations: pv[ply] holds the best line
+	 * found from the position at that ply (number of moves played), as
+	 * pv_length[ply] 0-based columns.
+	 */
+	int pv[MAX_PLY + 1][MAX_PLY];
+	int pv_length[MAX_PLY + 1];
+
+	/**
+	 * Number of moves played in the position being solved.
+	 */
+	int root_ply;
+
+	/**
+	 * Incremented for every evaluated position.
+	 */
+	int position_counter;
+
+	/**
+	 * Number of beta cutoffs in the last search, and how many of those were
+	 * caused by the first child explored.
+	 */
+	unsigned long long cutoffs;
+	unsigned long long first_child_cutoffs;
+
+	/**
+	 * Forget the killers, history and principal variations, and reset the
+	 * counters.
+	 */
+	void clear();
+};
+
+/**
+ * A class wrapping the negamax search, along with the state it needs (the
+ * static order in which columns are explored, the search context, the
+ * transposition table, and a flag allowing another thread to interrupt a
+ * running search). The transposition table is kept between searches, as the
+ * bounds it holds do not depend on the position being solved.
+ */
+class Engine {
+
+	public:
+		/**
+		 * Constructor, initialises the column exploration order and allocates
+		 * the transposition table.
+		 * @param table_size: the memory to use for the transposition table,
+		 *        in bytes
+		 * @param huge_pages: whether to try to back the transposition table
+		 *        with huge pages
+		 */
+		Engine(size_t table_size = TranspositionTable::DEFAULT_SIZE, bool huge_pages = false);
+
+		/**
+		 * Solve a position over the full score window.
+		 * @param P: the position to solve
+		 * @param position_counter: incremented for every evaluated position
+		 * @return the exact score of the position (see negamax), or an
+		 *         arbitrary value if the search was interrupted by stop()
+		 */
+		int solve(const Position& P, int& position_counter);
+
+		/**
+		 * @return the principal variation found by the last (uninterrupted)
+		 *         call to solve(), as 0-based columns starting with the best
+		 *         move: the line of play where both sides play perfectly, to
+		 *         the end of the game. It is read from the search's
+		 *         triangular PV array (see negamax), and is empty only if the
+		 *         game was already over.
+		 */
+		std::vector<int> get_principal_variation() const;
+
+		/**
+		 * Rebuild a principal variation for a position with a known exact
+		 * score from the transposition table and immediate wins alone,
+		 * without searching.
+		 * @param pv: filled with the line as 0-based columns; it stops early
+		 *        (possibly before the first move) where the table does not
+		 *        prove the next move
+		 * @return true if the line reaches the end of the game
+		 */
+		bool reconstruct_variation(const Position& P, int score, std::vector<int>& pv) const;
+
+		/**
+		 * @return the 0-based column that should be explored i-th (centre
+		 *         columns first)
+		 */
+		int get_column(int i) const;
+
+		/**
+		 * Ask any running search to unwind as soon as possible. Can be called
+		 * from another thread. Scores returned by an interrupted search are
+		 * meaningless and should be discarded.
+		 */
+		void stop();
+
+		/**
+		 * Clear a previous stop() request so that the engine can search again.
+		 */
+		void resume();
+
+		/**
+		 * @return true if stop() has been called since the last resume()
+		 */
+		bool is_stopped() const;
+
+		/**
+		 * @return the search context, e.g. to read its counters
+		 */
+		const SearchContext& get_context() const;
+
+		/**
+		 * @return the transposition table, e.g. to report its footprint
+		 */
+		const TranspositionTable& get_table() const;
+
+	private:
+		/**
+		 * Column values in the order that they should be explored (from the
+		 * centre columns).
+		 */
+		int columnOrder[Position::WIDTH];
+
+		SearchContext context;
+
+		TranspositionTable table;
+
+		std::atomic<bool> stopped;
+
+		/**
+		 * Recursively solve a connect4 position using the negamax variant of the
+		 * minimax algorithm with alpha-beta pruning. Bounds from the static
+		 * threat analysis (see Position::get_score_bounds()) and from the
+		 * transposition table narrow the window before children are explored,
+		 * children are explored in the order given by order_moves(), and the
+		 * search context is updated whenever a child causes a beta cutoff.
+		 * A known score only ends the search of a position if it falls
+		 * outside the window, so that positions on the principal variation
+		 * are always searched and the triangular PV array holds the whole
+		 * line.
+		 * @param alpha, the lower bound for the window in which we search for the
+		 *        score, which also represents the best score reached upstream so far
+		 *        by the maximiser.
+		 * @param beta, the upper bound for the window in which we search for the score,
+		 *        which also represents the best score reached upstream so far by the
+		 *        minimiser.
+		 * @return the exact score, or an upper or lower bound of the socre of a
+		 *         position depending on the case:
+		 *  - if alpha <= actual score <= beta, then return true score
+		 *  - if actual score <= alpha, then return upper bound of actual score
+		 *  - if actual score >= beta, then return lower bound of actual score
+		 *  - the scores will take the following values:
+		 *		- 0 for a draw
+		 *		- positive score for a forcing win, where the numerical value
+		 *		  corresponds to the number of turns before the maximum possible turns
+		 *		  that you win (that is, the earlier you win, the higher your score)
+		 *		- negative score for a forcing loss, where the numerical value
+		 *		  corresponds to the number of turns before the maximum possible turns
+		 *		  that you lose (that is, the earlier you lose, the lower your score)
+		 */
+		int negamax(const Position& P, int alpha, int beta, SearchContext& context);
+
+		/**
+		 * Fill moves with the playable columns of a position, best first:
+		 * killer moves for this ply, then by decreasing history score, with
+		 * ties broken by the static column order.
+		 * @return the number of playable columns
+		 */
+		int order_moves(const Position& P, const SearchContext& context, int moves[Position::WIDTH]) const;
+
+		/**
+		 * Record that playing col caused a beta cutoff in P.
+		 */
+		void record_cutoff(const Position& P, int col, SearchContext& context) const;
+
+		/**
+		 * Make col followed by the child's principal variation the principal
+		 * variation of P.
+		 */
+		void update_pv(const Position& P, int col, SearchContext& context) const;
+
+		/**
+		 * @return true if the score of P (from its current player's point of
+		 *         view) is known to be at most target, from the board alone
+		 *         or from the transposition table
+		 */
+		bool known_at_most(const Position& P, int target) const;
+
+};
+
+#endif
@@ -0,0 +1,350 @@
+/**
+ * fuzzer.cpp
+ * Purpose: differential fuzzer checking the optimised parts of the solver
+ * against the reference implementations they replace.
+ *
+ * Usage: fuzzer [options]
+ * Options:
+ * --iterations N: number of random games to check (default 20000).
+ * --seed S: seed for the random number generator (default 1).
+ * --solve-min M: only solve positions with at least M moves (default 26);
+ *   the reference search gets slow quickly on earlier positions.
+ * --table-mb N: transposition table size for the engine (default 1). A small
+ *   table exercises the replacement scheme.
+ * --replay MOVES: check a single move string instead of fuzzing, e.g. to
+ *   reproduce a reported failure.
+ *
+ * Each iteration plays a game of random length from uniformly random moves,
+ * never playing a move that would end the game. After every move the
+ * reference array-based Position methods (can_play, is_winning_move,
+ * get_moves, the board itself) are compared with what the bitboards say
+ * through the position key and the threat masks, and the position is rebuilt
+ * from its key. The final position, if it has enough moves, is solved by both
+ * the plain negamax of the original solver and the engine (transposition
+ * table, move ordering, static threat analysis), and the static score bounds
+ * and every move of the engine's principal variation are checked against the
+ * reference scores.
+ *
+ * The first failing game is shrunk to a minimal move string (by trying its
+ * prefixes and removing single moves while it still fails), which is written
+ * to the standard output with the failed check, and the fuzzer exits with
+ * status 1. The engine keeps its transposition table throughout, so a failure
+ * that depends on earlier searches may shrink less well.
+ *
+ * @author: Yuta Nagano
+ * @version: 1.1.1
+ */
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <random>
+#include <chrono>
+#include <stdexcept>
+#include <cstdint>
+#include "../position/position.hpp"
+#include "../engine/engine.hpp"
+
+using namespace std;
+using namespace std::chrono;
+
+/**
+ * Column values in the order that they should be explored by the reference
+ * search (from the centre columns), initialised within the main function.
+ */
+int columnOrder[Position::WIDTH];
+
+/**
+ * Fuzzing settings and counters.
+ */
+struct Fuzzer {
+	int solve_min;
+	unsigned long long positions = 0, solves = 0, nodes = 0;
+};
+
+/**
+ * The plain negamax of the original solver, without any of the engine's
+ * optimisations. See Engine::negamax for the meaning of the score.
+ */
+int reference_negamax(const Position& P, int alpha, int beta, unsigned long long& position_counter);
+
+/**
+ * @return the height of a column, read from the marker bit of the position
+ *         key (see Position::get_key())
+ */
+int key_height(uint64_t key, int col);
+
+/**
+ * Compare the reference Position methods with the bitboards on a position.
+ * @return a description of the first mismatch, or an empty string
+ */
+string check_kernels(const Position& P);
+
+/**
+ * Compare the engine with the reference search on a position.
+ * @return a description of the first mismatch, or an empty string
+ */
+string check_solve(const Position& P, Engine& engine, Fuzzer& fz);
+
+/**
+ * Replay a move string, checking every position along the way and solving
+ * the last one if it has enough moves.
+ * @param valid: set to false if the string is not a game in progress (an
+ *        unplayable column, or a move that ends the game)
+ * @return a description of the first failed check, or an empty string
+ */
+string check_line(const string& line, Engine& engine, Fuzzer& fz, bool& valid);
+
+/**
+ * Shrink a failing move string while it still fails.
+ * @return the shortest failing string found, with its failed check in reason
+ */
+string shrink(string line, Engine& engine, Fuzzer& fz, string& reason);
+
+/**
+ * Play a random game of the given length (or shorter if no move can continue
+ * it), never playing a move that would end the game.
+ */
+string random_line(int moves, mt19937_64& rng);
+
+int main(int argc, char* argv[]) {
+	for (int i = 0; i < Position::WIDTH; i++)
+		columnOrder[i] = Position::WIDTH/2 + (i+1)/2 * (1-2*(i%2));
+
+	Fuzzer fz;
+	fz.solve_min = 26;
+	unsigned long long iterations = 20000, seed = 1;
+	size_t table_size = size_t(1) << 20;
+	string replay;
+	bool replaying = false;
+
+	for (int i = 1; i < argc; i++) {
+		string arg = argv[i];
+		if (arg == "--iterations" && i + 1 < argc) iterations = stoull(argv[++i]);
+		else if (arg == "--seed" && i + 1 < argc) seed = stoull(argv[++i]);
+		else if (arg == "--solve-min" && i + 1 < argc) fz.solve_min = stoi(argv[++i]);
+		else if (arg == "--table-mb" && i + 1 < argc) table_size = stoull(argv[++i]) << 20;
+		else if (arg == "--replay" && i + 1 < argc) {
+			replay = argv[++i];
+			replaying = true;
+		}
+		else {
+			cerr << "Usage: fuzzer [--iterations N] [--seed S] [--solve-min M] [--table-mb N] [--replay MOVES]" << endl;
+			return 1;
+		}
+	}
+
+	Engine engine(table_size);
+	mt19937_64 rng(seed);
+	uniform_int_distribution<int> move_count(0, Position::WIDTH * Position::HEIGHT - 1);
+	high_resolution_clock::time_point start = high_resolution_clock::now();
+
+	for (unsigned long long it = 0; it < (replaying ? 1 : iterations); it++) {
+		string line = replaying ? replay : random_line(move_count(rng), rng);
+		bool valid;
+		string reason = check_line(line, engine, fz, valid);
+		if (!valid) {
+			cerr << "Error: " << line << " is not a game in progress." << endl;
+			return 1;
+		}
+		if (reason.empty()) continue;
+
+		cout << "Failed: " << (line.empty() ? "(empty)" : line) << ": " << reason << endl;
+		string minimal = shrink(line, engine, fz, reason);
+		cout << "Shrunk: " << (minimal.empty() ? "(empty)" : minimal) << ": " << reason << endl;
+		return 1;
+	}
+
+	duration<double> elapsed = high_resolution_clock::now() - start;
+	cout << "Checked " << fz.positions << " positions and " << fz.solves << " solves (" << \
+		fz.nodes << " reference nodes) in " << elapsed.count() << " s: no mismatches found." << endl;
+
+	return 0;
+}
+
+int reference_negamax(const Position& P, int alpha, int beta, unsigned long long& position_counter) {
+	position_counter++;
+
+	if (P.get_moves() == Position::WIDTH * Position::HEIGHT) return 0;
+
+	for (int i = 0; i < Position::WIDTH; i++)
+		if (P.can_play(i) && P.is_winning_move(i))
+			return (Position::WIDTH * Position::HEIGHT - P.get_moves() + 1) / 2;
+
+	int maxScore = (Position::WIDTH * Position::HEIGHT - P.get_moves() - 1) / 2;
+	if (beta > maxScore) {
+		beta = maxScore;
+		if (alpha >= beta) return beta;
+	}
+
+	for (int i = 0; i < Position::WIDTH; i++) {
+		int move = columnOrder[i];
+		if (P.can_play(move)) {
+			Position P2(P);
+			P2.play(move);
+			int score = -reference_negamax(P2, -beta, -alpha, position_counter);
+			if (score >= beta) return score;
+			if (score > alpha) alpha = score;
+		}
+	}
+
+	return alpha;
+}
+
+int key_height(uint64_t key, int col) {
+	uint64_t column = (key >> (col * (Position::HEIGHT + 1))) & ((UINT64_C(1) << (Position::HEIGHT + 1)) - 1);
+	return 63 - __builtin_clzll(column);
+}
+
+string check_kernels(const Position& P) {
+	uint64_t key = P.get_key();
+	uint64_t threats = P.get_threats();
+
+	unsigned int moves = 0;
+	for (int col = 0; col < Position::WIDTH; col++) {
+		int height = key_height(key, col);
+		moves += height;
+		if (height != P.get_height(col))
+			return "height of column " + to_string(col + 1) + " differs from the key";
+		if (P.can_play(col) != (height < Position::HEIGHT))
+			return "can_play(" + to_string(col) + ") differs from the key";
+		if (!P.can_play(col)) continue;
+		bool threat = (threats >> (col * (Position::HEIGHT + 1) + height)) & 1;
+		if (P.is_winning_move(col) != threat)
+			return "is_winning_move(" + to_string(col) + ") differs from get_threats()";
+	}
+	if (P.get_moves() != moves)
+		return "get_moves() differs from the key";
+
+	// A key the constructor rejects is a failed check too, not a crash
+	try {
+		Position rebuilt(key);
+		if (rebuilt.get_moves() != P.get_moves() || rebuilt.get_key() != key)
+			return "position rebuilt from its key differs";
+		for (int col = 0; col < Position::WIDTH; col++)
+			for (int row = 0; row < Position::HEIGHT; row++)
+				if (rebuilt.get_board(col, row) != P.get_board(col, row))
+					return "board rebuilt from the key differs";
+	}
+	catch (const runtime_error& e) {
+		return "position could not be rebuilt from its key: " + string(e.what());
+	}
+
+	return "";
+}
+
+string check_solve(const Position& P, Engine& engine, Fuzzer& fz) {
+	int baseScore = Position::WIDTH * Position::HEIGHT / 2;
+	int score = reference_negamax(P, -baseScore, baseScore, fz.nodes);
+	fz.solves++;
+
+	int min_score, max_score;
+	P.get_score_bounds(min_score, max_score);
+	if (score < min_score || score > max_score)
+		return "reference score " + to_string(score) + " outside get_score_bounds() [" + \
+			to_string(min_score) + ", " + to_string(max_score) + "]";
+
+	int counter = 0;
+	int engineScore = engine.solve(P, counter);
+	if (engineScore != score)
+		return "engine score " + to_string(engineScore) + " differs from reference score " + to_string(score);
+
+	// Every move of the principal variation must keep the score (each
+	// position along it is worth the negation of the one before), and the
+	// game must end exactly at its last move
+	vector<int> pv = engine.get_principal_variation();
+	Position current(P);
+	for (size_t i = 0; i < pv.size(); i++) {
+		string move = "principal variation move " + to_string(i + 1) + " (" + to_string(pv[i] + 1) + ")";
+		if (pv[i] < 0 || pv[i] >= Position::WIDTH || !current.can_play(pv[i]))
+			return move + " is not playable";
+		if (current.is_winning_move(pv[i])) {
+			if (i + 1 != pv.size())
+				return move + " wins but the line goes on";
+			if (score != (Position::WIDTH * Position::HEIGHT - int(current.get_moves()) + 1) / 2)
+				return move + " wins but the score does not";
+			return "";
+		}
+		current.play(pv[i]);
+		score = -score;
+		int childScore = current.get_moves() == Position::WIDTH * Position::HEIGHT ? 0 : \
+			reference_negamax(current, -baseScore, baseScore, fz.nodes);
+		if (childScore != score)
+			return move + " leads to a position worth " + to_string(childScore) + " instead of " + to_string(score);
+	}
+	if (current.get_moves() != Position::WIDTH * Position::HEIGHT)
+		return "principal variation of " + to_string(pv.size()) + " moves stops before the end of the game";
+
+	return "";
+}
+
+string check_line(const string& line, Engine& engine, Fuzzer& fz, bool& valid) {
+	valid = false;
+	Position P;
+	for (size_t i = 0; i <= line.size(); i++) {
+		fz.positions++;
+		string reason = check_kernels(P);
+		if (!reason.empty()) {
+			valid = true;
+			return "after " + to_string(i) + " moves, " + reason;
+		}
+		if (i == line.size()) break;
+
+		int col = line[i] - '1';
+		if (col < 0 || col >= Position::WIDTH || !P.can_play(col) || P.is_winning_move(col)) return "";
+		P.play(col);
+	}
+	valid = true;
+
+	if (int(P.get_moves()) < fz.solve_min || P.get_moves() == Position::WIDTH * Position::HEIGHT) return "";
+	return check_solve(P, engine, fz);
+}
+
+string shrink(string line, Engine& engine, Fuzzer& fz, string& reason) {
+	bool shrunk = true;
+	while (shrunk) {
+		shrunk = false;
+		bool valid;
+
+		// Shortest failing prefix first, as kernel mismatches show up early
+		for (size_t length = 0; length < line.size() && !shrunk; length++) {
+			string candidate = line.substr(0, length);
+			string r = check_line(candidate, engine, fz, valid);
+			if (valid && !r.empty()) {
+				line = candidate;
+				reason = r;
+				shrunk = true;
+			}
+		}
+
+		// Then try removing each move in turn
+		for (size_t i = 0; i < line.size() && !shrunk; i++) {
+			string candidate = line.substr(0, i) + line.substr(i + 1);
+			string r = check_line(candidate, engine, fz, valid);
+			if (valid && !r.empty()) {
+				line = candidate;
+				reason = r;
+				shrunk = true;
+			}
+		}
+	}
+	return line;
+}
+
+string random_line(int moves, mt19937_64& rng) {
+	Position P;
+	string line;
+
+	while (int(P.get_moves()) < moves) {
+		int options[Position::WIDTH], n = 0;
+		for (int col = 0; col < Position::WIDTH; col++)
+			if (P.can_play(col) && !P.is_winning_move(col)) options[n++] = col;
+		if (n == 0) break;
+
+		int col = options[rng() % n];
+		P.play(col);
+		line += char('1' + col);
+	}
+
+	return line;
+}
@@ -0,0 +1,220 @@
+/**
+ * generator.cpp
+ * Purpose: generator program for labelled test sets, in the same "moves score"
+ * format as the files in test_sets.
+ *
+ * Usage: generator <count> <min moves> <max moves> [options]
+ * - count: number of positions to generate
+ * - min moves, max moves: range for the number of moves played in each
+ *   position (inclusive)
+ * Options:
+ * --band MIN MAX: only keep positions whose game lasts between MIN and MAX
+ *   more moves under perfect play (inclusive). The existing test sets use
+ *   bands of roughly 1-14 (R1), 14-28 (R2) and 28-42 (R3). A band that no
+ *   position in the move range can reach is rejected, and generation stops
+ *   with a warning if too many positions in a row fall outside the band.
+ * --threads N: number of positions to label in parallel (default: number of
+ *   cores).
+ * --seed S: seed for the random number generators (default 1).
+ * --table-mb N: transposition table size for each thread (default 64).
+ *
+ * Positions are sampled by playing uniformly random moves, never playing a
+ * move that would end the game, so every position is legal and still in play.
+ * Each one is then labelled with its exact score by the solver's engine.
+ * Positions that are duplicates of an earlier one, or of its mirror image, are
+ * dropped. The labelled positions are written to the standard output, in no
+ * particular order; a summary is written to the standard error.
+ *
+ * @author: Yuta Nagano
+ * @version: 1.0.1
+ */
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <unordered_set>
+#include <random>
+#include <thread>
+#include <mutex>
+#include <algorithm>
+#include <stdexcept>
+#include <cstdint>
+#include "../position/position.hpp"
+#include "../engine/engine.hpp"
+
+using namespace std;
+
+/**
+ * Generation settings and state shared between the worker threads. Everything
+ * below the mutex is protected by it.
+ */
+struct Generator {
+	int count, min_moves, max_moves, min_band, max_band;
+	size_t table_size;
+
+	mutex lock;
+	int accepted = 0, duplicates = 0, out_of_band = 0;
+	int duplicate_run = 0, out_of_band_run = 0;
+	unordered_set<uint64_t> seen;
+};
+
+/**
+ * Give up once this many samples in a row were duplicates: there are probably
+ * not enough distinct positions in the requested range.
+ */
+const int MAX_DUPLICATE_RUN = 1000000;
+
+/**
+ * Give up once this many labelled samples in a row were outside the band: the
+ * band is probably out of reach of most positions in the move range.
+ */
+const int MAX_OUT_OF_BAND_RUN = 10000;
+
+/**
+ * Play random moves until the position has the given number of moves, never
+ * playing a winning move.
+ * @return false if the game could not be continued that far
+ */
+bool sample_position(int moves, mt19937_64& rng, Position& P, string& line);
+
+/**
+ * @return a key shared by a position and its mirror image
+ */
+uint64_t canonical_key(const string& line);
+
+/**
+ * @return the number of moves left in the game under perfect play, for a
+ *         position with the given number of moves and score
+ */
+int remaining_moves(int moves, int score);
+
+/**
+ * Body of a worker thread: sample, deduplicate, label and output positions
+ * until enough have been accepted.
+ */
+void work(Generator& gen, uint64_t seed);
+
+int main(int argc, char* argv[]) {
+	if (argc < 4) {
+		cerr << "Usage: generator <count> <min moves> <max moves> [--band MIN MAX] [--threads N] [--seed S] [--table-mb N]" << endl;
+		return 1;
+	}
+
+	Generator gen;
+	gen.count = stoi(argv[1]);
+	gen.min_moves = stoi(argv[2]);
+	gen.max_moves = stoi(argv[3]);
+	gen.min_band = 0;
+	gen.max_band = Position::WIDTH * Position::HEIGHT;
+	gen.table_size = TranspositionTable::DEFAULT_SIZE;
+	int threads = max(1u, thread::hardware_concurrency());
+	uint64_t seed = 1;
+
+	for (int i = 4; i < argc; i++) {
+		string arg = argv[i];
+		if (arg == "--band" && i + 2 < argc) {
+			gen.min_band = stoi(argv[++i]);
+			gen.max_band = stoi(argv[++i]);
+		}
+		else if (arg == "--threads" && i + 1 < argc) threads = stoi(argv[++i]);
+		else if (arg == "--seed" && i + 1 < argc) seed = stoull(argv[++i]);
+		else if (arg == "--table-mb" && i + 1 < argc) gen.table_size = stoull(argv[++i]) << 20;
+		else throw runtime_error("Unrecognised option: " + arg);
+	}
+
+	if (gen.min_moves < 0 || gen.max_moves >= Position::WIDTH * Position::HEIGHT || gen.min_moves > gen.max_moves)
+		throw runtime_error("Move range must be within [0, WIDTH*HEIGHT).");
+
+	// A position still in play has between 1 and WIDTH*HEIGHT - moves moves
+	// left, so the band must overlap that range for the shortest games
+	if (gen.min_band > gen.max_band || gen.max_band < 1 || \
+			gen.min_band > Position::WIDTH * Position::HEIGHT - gen.min_moves)
+		throw runtime_error("Band cannot be reached from the move range.");
+
+	vector<thread> workers;
+	for (int t = 0; t < threads; t++) workers.emplace_back(work, ref(gen), seed + t);
+	for (thread& worker : workers) worker.join();
+
+	if (gen.duplicate_run >= MAX_DUPLICATE_RUN)
+		cerr << "Warning: ran out of distinct positions, stopping early." << endl;
+	if (gen.out_of_band_run >= MAX_OUT_OF_BAND_RUN)
+		cerr << "Warning: too few positions fall within the band, stopping early." << endl;
+	cerr << "Generated " << gen.accepted << " positions (dropped " << gen.duplicates << \
+		" duplicates and " << gen.out_of_band << " outside the band)." << endl;
+
+	return 0;
+}
+
+bool sample_position(int moves, mt19937_64& rng, Position& P, string& line) {
+	P = Position();
+	line.clear();
+
+	while (int(P.get_moves()) < moves) {
+		int options[Position::WIDTH], n = 0;
+		for (int col = 0; col < Position::WIDTH; col++)
+			if (P.can_play(col) && !P.is_winning_move(col)) options[n++] = col;
+		if (n == 0) return false;
+
+		int col = options[rng() % n];
+		P.play(col);
+		line += char('1' + col);
+	}
+
+	return true;
+}
+
+uint64_t canonical_key(const string& line) {
+	string mirror(line);
+	for (char& c : mirror) c = char('1' + Position::WIDTH - 1 - (c - '1'));
+	return min(Position(line).get_key(), Position(mirror).get_key());
+}
+
+int remaining_moves(int moves, int score) {
+	// A score of s means the winner plays their last stone with
+	// WIDTH*HEIGHT+1-2|s| stones on the board (see Engine::negamax)
+	if (score == 0) return Position::WIDTH * Position::HEIGHT - moves;
+	return Position::WIDTH * Position::HEIGHT + 1 - 2 * abs(score) - moves;
+}
+
+void work(Generator& gen, uint64_t seed) {
+	mt19937_64 rng(seed);
+	uniform_int_distribution<int> move_count(gen.min_moves, gen.max_moves);
+	Engine engine(gen.table_size);
+	Position P;
+	string line;
+
+	while (true) {
+		int moves = move_count(rng);
+		if (!sample_position(moves, rng, P, line)) continue;
+
+		// Claim the position before labelling it, so that no two threads
+		// spend time on the same one
+		uint64_t key = canonical_key(line);
+		{
+			lock_guard<mutex> guard(gen.lock);
+			if (gen.accepted >= gen.count || gen.duplicate_run >= MAX_DUPLICATE_RUN || \
+					gen.out_of_band_run >= MAX_OUT_OF_BAND_RUN) return;
+			if (!gen.seen.insert(key).second) {
+				gen.duplicates++;
+				gen.duplicate_run++;
+				continue;
+			}
+			gen.duplicate_run = 0;
+		}
+
+		int counter = 0;
+		int score = engine.solve(P, counter);
+		int remaining = remaining_moves(moves, score);
+
+		lock_guard<mutex> guard(gen.lock);
+		if (gen.accepted >= gen.count || gen.out_of_band_run >= MAX_OUT_OF_BAND_RUN) return;
+		if (remaining < gen.min_band || remaining > gen.max_band) {
+			gen.out_of_band++;
+			gen.out_of_band_run++;
+			continue;
+		}
+		gen.out_of_band_run = 0;
+		gen.accepted++;
+		cout << line << " " << score << '\n';
+	}
+}
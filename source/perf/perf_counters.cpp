@@ -0,0 +1,115 @@
+/**
+ * perf_counters.cpp
+ * Purpose: Implementation for a class reading hardware performance counters of
+ * the calling thread.
+ *
+ * @author Yuta Nagano
+ * @version 1.0.0
+ */
+
+#include "perf_counters.hpp"
+
+#ifdef __linux__
+#include <cstring>
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <linux/perf_event.h>
+#endif
+
+const char* const PerfCounters::NAMES[N_COUNTERS] = {"cycles", "instructions", "branch_misses", "l1d_misses", "llc_misses"};
+
+#ifdef __linux__
+
+/**
+ * The perf event type and config for each counter.
+ */
+static const uint32_t TYPES[PerfCounters::N_COUNTERS] = {
+	PERF_TYPE_HARDWARE, PERF_TYPE_HARDWARE, PERF_TYPE_HARDWARE, PERF_TYPE_HW_CACHE, PERF_TYPE_HW_CACHE
+};
+static const uint64_t CONFIGS[PerfCounters::N_COUNTERS] = {
+	PERF_COUNT_HW_CPU_CYCLES,
+	PERF_COUNT_HW_INSTRUCTIONS,
+	PERF_COUNT_HW_BRANCH_MISSES,
+	PERF_COUNT_HW_CACHE_L1D | (PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16),
+	PERF_COUNT_HW_CACHE_LL | (PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16)
+};
+
+// Constructors
+
+PerfCounters::PerfCounters() {
+	for (int i = 0; i < N_COUNTERS; i++) {
+		perf_event_attr attr;
+		memset(&attr, 0, sizeof(attr));
+		attr.size = sizeof(attr);
+		attr.type = TYPES[i];
+		attr.config = CONFIGS[i];
+		attr.disabled = 1;
+		// Counting user space only keeps this usable without privileges on
+		// most systems (perf_event_paranoid <= 2)
+		attr.exclude_kernel = 1;
+		attr.exclude_hv = 1;
+		attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+		fds[i] = syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0);
+	}
+}
+
+PerfCounters::~PerfCounters() {
+	for (int i = 0; i < N_COUNTERS; i++)
+		if (fds[i] >= 0) close(fds[i]);
+}
+
+// Public methods
+
+void PerfCounters::start() {
+	for (int i = 0; i < N_COUNTERS; i++) {
+		if (fds[i] < 0) continue;
+		ioctl(fds[i], PERF_EVENT_IOC_RESET, 0);
+		ioctl(fds[i], PERF_EVENT_IOC_ENABLE, 0);
+	}
+}
+
+void PerfCounters::stop() {
+	for (int i = 0; i < N_COUNTERS; i++)
+		if (fds[i] >= 0) ioctl(fds[i], PERF_EVENT_IOC_DISABLE, 0);
+}
+
+uint64_t PerfCounters::get(Counter counter) const {
+	if (fds[counter] < 0) return 0;
+
+	// value, time enabled, time running
+	uint64_t data[3];
+	if (read(fds[counter], data, sizeof(data)) != sizeof(data) || data[2] == 0) return 0;
+	if (data[2] == data[1]) return data[0];
+	return uint64_t(double(data[0]) * data[1] / data[2]);
+}
+
+#else
+
+// Without perf_event_open, no counter is ever available
+
+PerfCounters::PerfCounters() {
+	for (int i = 0; i < N_COUNTERS; i++) fds[i] = -1;
+}
+
+PerfCounters::~PerfCounters() {}
+
+void PerfCounters::start() {}
+
+void PerfCounters::stop() {}
+
+uint64_t PerfCounters::get(Counter counter) const {
+	return 0;
+}
+
+#endif
+
+bool PerfCounters::is_available(Counter counter) const {
+	return fds[counter] >= 0;
+}
+
+bool PerfCounters::any_available() const {
+	for (int i = 0; i < N_COUNTERS; i++)
+		if (fds[i] >= 0) return true;
+	return false;
+}
@@ -0,0 +1,74 @@
+/**
+ * perf_counters.hpp
+ * Purpose: A definition for a class reading hardware performance counters of
+ * the calling thread.
+ *
+ * @author Yuta Nagano
+ * @version 1.0.0
+ */
+
+#ifndef PERF_COUNTERS_HEADER
+#define PERF_COUNTERS_HEADER
+
+#include <cstdint>
+
+/**
+ * A class counting hardware events (cycles, instructions, branch misses and
+ * cache misses) for the calling thread, in user space only, between calls to
+ * start() and stop(). Built on Linux's perf_event_open. Each counter is opened
+ * separately, so counters the hardware or the kernel settings do not allow
+ * are simply reported as unavailable while the others keep working.
+ */
+class PerfCounters {
+
+	public:
+		enum Counter {CYCLES, INSTRUCTIONS, BRANCH_MISSES, L1D_MISSES, LLC_MISSES, N_COUNTERS};
+
+		/**
+		 * Short names of the counters, e.g. for column headers.
+		 */
+		static const char* const NAMES[N_COUNTERS];
+
+		/**
+		 * Constructor, try to open every counter. Counters start stopped.
+		 */
+		PerfCounters();
+
+		~PerfCounters();
+
+		PerfCounters(const PerfCounters&) = delete;
+		PerfCounters& operator=(const PerfCounters&) = delete;
+
+		/**
+		 * @return true if the given counter could be opened
+		 */
+		bool is_available(Counter counter) const;
+
+		/**
+		 * @return true if at least one counter could be opened
+		 */
+		bool any_available() const;
+
+		/**
+		 * Reset all counters to zero and start counting.
+		 */
+		void start();
+
+		/**
+		 * Stop counting.
+		 */
+		void stop();
+
+		/**
+		 * @return the events counted between the last start() and stop(),
+		 *         scaled up if the kernel had to share the hardware counter
+		 *         with other events, or 0 if the counter is unavailable
+		 */
+		uint64_t get(Counter counter) const;
+
+	private:
+		int fds[N_COUNTERS];
+
+};
+
+#endif
@@ -3,7 +3,7 @@
  * Purpose: Implementation for a class storing a Connect4 position.
  *
  * @author Yuta Nagano
- * @version 1.0.1
+ * @version 1.3.1
  */
 
 #include <stdexcept>
@@ -15,11 +15,29 @@
 
 using namespace std;
 
+// Bitboard constants (see the bitboards in position.hpp)
+
+static const int H1 = Position::HEIGHT + 1;
+
+/**
+ * @return a bitboard with the given bits set in every column
+ */
+static uint64_t every_column(uint64_t column) {
+	uint64_t board = 0;
+	for (int i=0; i<Position::WIDTH; i++) board |= column << (i * H1);
+	return board;
+}
+
+static const uint64_t BOTTOM_MASK = every_column(1);
+static const uint64_t BOARD_MASK = every_column((UINT64_C(1) << Position::HEIGHT) - 1);
+static const uint64_t ODD_ROWS_MASK = every_column(0x15);
+static const uint64_t EVEN_ROWS_MASK = every_column(0x2A);
+
 // Constructors
 
-Position::Position() : board{0}, heights{0}, moves{0} {}
+Position::Position() : board{0}, heights{0}, moves{0}, current{0}, mask{0} {}
 
-Position::Position(string moves) : board{0}, heights{0}, moves{0} {
+Position::Position(string moves) : board{0}, heights{0}, moves{0}, current{0}, mask{0} {
 	// Assert that the string moves only contains digits
 	if (!all_of(moves.begin(), moves.end(), ::isdigit))
 		throw runtime_error("a string containing non-digit characters cannot be passed to Position constructor.");
@@ -30,6 +48,38 @@ Position::Position(string moves) : board{0}, heights{0}, moves{0} {
 	}
 }
 
+Position::Position(uint64_t key) : board{0}, heights{0}, moves{0}, current{0}, mask{0} {
+	// Only the WIDTH columns of HEIGHT+1 bits may be used
+	if (key >> (WIDTH * (HEIGHT + 1)))
+		throw runtime_error("a key with bits set above the last column cannot be passed to Position constructor.");
+
+	for (int col=0; col<WIDTH; col++) {
+		// Each column holds the current player's pieces plus a marker bit
+		// directly above the highest piece (see get_key())
+		uint64_t column = (key >> (col * (HEIGHT + 1))) & ((UINT64_C(1) << (HEIGHT + 1)) - 1);
+		if (column == 0)
+			throw runtime_error("a key with an empty column cannot be passed to Position constructor.");
+
+		int height = HEIGHT;
+		while (!(column >> height)) height--;
+
+		for (int row=0; row<height; row++) {
+			bool mine = (column >> row) & 1;
+			board[col][row] = mine ? 1 : -1;
+			uint64_t bit = UINT64_C(1) << (col * (HEIGHT + 1) + row);
+			mask |= bit;
+			if (mine) current |= bit;
+		}
+		heights[col] = height;
+		moves += height;
+	}
+
+	// The players take turns, so the current player has played exactly half
+	// of the moves (rounded down)
+	if (__builtin_popcountll(current) != int(moves / 2))
+		throw runtime_error("a key with unbalanced piece counts cannot be passed to Position constructor.");
+}
+
 // Public methods
 
 bool Position::can_play(int col) const {
@@ -48,6 +98,11 @@ void Position::play(int col) {
 	// Add a current player piece (1) to the specified column at the appropriate height
 	board[col][heights[col]] = 1;
 
+	// Mirror the play on the bitboards: the opponent's pieces become the
+	// current player's pieces, then the new piece is added to the mask
+	current ^= mask;
+	mask |= UINT64_C(1) << (col * (HEIGHT + 1) + heights[col]);
+
 	// Increment the appropriate entry in the heights array by 1
 	heights[col]++;
 
@@ -136,8 +191,93 @@ unsigned int Position::get_moves() const {
 	return moves;
 }
 
+uint64_t Position::get_key() const {
+	// Adding a bit at the bottom of every column turns the mask into a
+	// marker bit sitting directly above the highest piece in each column,
+	// which encodes the column heights and keeps the key unique.
+	return current + mask + BOTTOM_MASK;
+}
+
+uint64_t Position::get_threats(bool opponent) const {
+	return winning_cells(opponent ? current ^ mask : current, mask);
+}
+
+void Position::get_score_bounds(int& min_score, int& max_score) const {
+	int left = WIDTH * HEIGHT - moves;
+	uint64_t opponent = current ^ mask;
+	uint64_t empty = BOARD_MASK & ~mask;
+	uint64_t playable = (mask + BOTTOM_MASK) & BOARD_MASK;
+
+	// An immediate win is the best possible score
+	if (winning_cells(current, mask) & playable) {
+		min_score = max_score = (left + 1) / 2;
+		return;
+	}
+
+	// Otherwise we must block any immediately playable opponent threat, and
+	// must not play directly below an opponent threat. If that leaves no
+	// move, the opponent wins on their next move.
+	uint64_t opponent_threats = winning_cells(opponent, mask);
+	uint64_t forced = opponent_threats & playable;
+	uint64_t safe = (forced ? forced : playable) & ~(opponent_threats >> 1);
+	if (!safe || (forced & (forced - 1))) {
+		min_score = max_score = -left / 2;
+		return;
+	}
+
+	// We cannot win on this move, and the opponent cannot win on their next
+	min_score = -(left - 2) / 2;
+	max_score = (left - 1) / 2;
+
+	// A side without a line that avoids the other side's pieces cannot win
+	if (!has_alignment(current | empty)) max_score = min(max_score, 0);
+	if (!has_alignment(opponent | empty)) min_score = max(min_score, 0);
+
+	// Claimeven: with an even number of empty cells in every column (which
+	// means every column height is even), the opponent can answer each of our
+	// moves on top of it, getting every empty even row cell and leaving us
+	// every empty odd row cell
+	if (!(mask & ODD_ROWS_MASK & ~(mask >> 1))) {
+		if (!has_alignment(current | (empty & ODD_ROWS_MASK))) {
+			max_score = min(max_score, 0);
+			if (has_alignment(opponent | (empty & EVEN_ROWS_MASK))) max_score = min(max_score, -1);
+		}
+	}
+}
+
 // Private methods
 
+uint64_t Position::winning_cells(uint64_t pieces, uint64_t mask) {
+	// Vertical: three pieces directly below the cell
+	uint64_t cells = (pieces << 1) & (pieces << 2) & (pieces << 3);
+
+	// Horizontal and both diagonals: for a line direction d (in bits), the cell
+	// completes a line if the three other cells of one of the four windows
+	// through it hold pieces
+	const int directions[3] = {H1, H1 - 1, H1 + 1};
+	for (int d : directions) {
+		uint64_t pair = (pieces << d) & (pieces << 2 * d);
+		cells |= pair & (pieces << 3 * d);
+		cells |= pair & (pieces >> d);
+		pair = (pieces >> d) & (pieces >> 2 * d);
+		cells |= pair & (pieces << d);
+		cells |= pair & (pieces >> 3 * d);
+	}
+
+	return cells & BOARD_MASK & ~mask;
+}
+
+bool Position::has_alignment(uint64_t pieces) {
+	pieces &= BOARD_MASK;
+	// Vertical, horizontal and both diagonals
+	const int directions[4] = {1, H1, H1 - 1, H1 + 1};
+	for (int d : directions) {
+		uint64_t pair = pieces & (pieces >> d);
+		if (pair & (pair >> 2 * d)) return true;
+	}
+	return false;
+}
+
 void Position::flip_board() {
 	// Replace all 1's (current player pieces) with -1's (opponent player pieces)
 	// and vice versa
@@ -3,13 +3,14 @@
 	Purpose: A definition for a class storing a Connect 4 position.
 
 	@author Yuta Nagano
-	@version 1.0.0
+	@version 1.3.1
 */
 
 #ifndef POSITION_HEADER
 #define POSITION_HEADER
 
 #include<string>
+#include<cstdint>
 
 using namespace std;
 
@@ -36,6 +37,13 @@ class Position {
 		*/
 		Position(string moves);
 
+		/**
+		 * Constructor rebuilding a position from its key (see get_key()).
+		 * Throws a runtime error if the key does not describe a position that
+		 * can be reached in a game.
+		 */
+		explicit Position(uint64_t key);
+
 		/**
 		Indicates whether a column is playable.
 		@param col: 0-based index of column to play
@@ -73,11 +81,73 @@ class Position {
 		*/
 		unsigned int get_moves() const;
 
+		/**
+		 * @return a unique key for the current position, relative to the
+		 *         current player. Two positions that are reached by different
+		 *         move orders but have the same pieces on the board share the
+		 *         same key. The key is never 0.
+		 */
+		uint64_t get_key() const;
+
+		/**
+		 * @return a bitmask (laid out like the bitboards below) of the empty
+		 *         cells that would complete four in a row for the current
+		 *         player, or for the opponent if opponent is true. The cells
+		 *         need not be playable yet. A playable cell in the current
+		 *         player's threats is a winning move (see is_winning_move()).
+		 */
+		uint64_t get_threats(bool opponent = false) const;
+
+		/**
+		 * Static threat analysis: bound the score of the position (see
+		 * Engine::negamax) without searching, from the threats each side has
+		 * and the lines each side can still complete. The rules used are:
+		 * - an immediate win, or having no move that avoids losing on the
+		 *   opponent's next move, gives the exact score
+		 * - otherwise, the score cannot be the best or worst possible
+		 * - a side with no line left to complete cannot win
+		 * - if every column has an even number of empty cells, the opponent
+		 *   can answer every move in the same column ("claimeven") and so
+		 *   take every empty cell in the even rows, leaving the current
+		 *   player only the odd rows: if that blocks all of the current
+		 *   player's lines they cannot win, and if it also completes a line
+		 *   for the opponent they lose.
+		 * There is no matching rule for the current player's odd row threats:
+		 * answering in the same column stops working once the opponent fills
+		 * a column, so which cells each side gets is no longer fixed.
+		 * This function should not be called on a position where the game
+		 * is already over.
+		 * @param min_score, max_score: set to the bounds of the score (equal
+		 *        if the exact score is known)
+		 */
+		void get_score_bounds(int& min_score, int& max_score) const;
+
 	private:
 		int board[WIDTH][HEIGHT];
 		int heights[WIDTH];
 		unsigned int moves;
 
+		/**
+		 * Bitboard mirrors of the board array, used to compute position keys
+		 * in constant time. Each column takes HEIGHT+1 bits (the extra bit
+		 * sits above the top row), with bit col*(HEIGHT+1)+row set if that
+		 * cell is occupied (mask) or occupied by the current player (current).
+		 */
+		uint64_t current;
+		uint64_t mask;
+
+		/**
+		 * @return a bitmask of the cells outside of mask that would complete
+		 *         four in a row with pieces
+		 */
+		static uint64_t winning_cells(uint64_t pieces, uint64_t mask);
+
+		/**
+		 * @return true if pieces (which must not use the extra bit above each
+		 *         column) contain four in a row
+		 */
+		static bool has_alignment(uint64_t pieces);
+
 		/**
 		 * Change the perspective of the board so that the current player
 		 * switches.
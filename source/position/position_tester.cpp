@@ -3,7 +3,7 @@
  * Purpose: Unit test for the position class.
  *
  * @author Yuta Nagano
- * @version 1.0.1
+ * @version 1.3.1
  */
 
 #include <iostream>
@@ -228,6 +228,95 @@ int main() {
 		if (test.is_winning_move(i)) return fail("is_winning_move() falsely detected a win-in-1 when there were none.");
 	}
 
+	// Test the get_key() method
+	// Different move orders reaching the same position should share a key
+	if (Position("4453").get_key() != Position("4354").get_key()) {
+		return fail("get_key() returned different keys for transposed positions.");
+	}
+	// The same pieces seen from different players' perspectives, or positions
+	// differing only in column heights, should not share a key
+	if (Position("44").get_key() == Position("4").get_key() || \
+			Position("12").get_key() == Position("21").get_key() || \
+			Position("1").get_key() == Position("2").get_key()) {
+		return fail("get_key() returned the same key for different positions.");
+	}
+	if (Position().get_key() == 0) {
+		return fail("get_key() returned 0 for the empty position.");
+	}
+
+	// Test the key constructor
+	// Rebuilding a position from its key should give back the same board
+	Position original("44455554221");
+	Position rebuilt(original.get_key());
+	if (rebuilt.get_key() != original.get_key() || rebuilt.get_moves() != original.get_moves()) {
+		return fail("Key constructor did not rebuild the position.");
+	}
+	for (int col = 0; col<test.WIDTH; col++) {
+		if (rebuilt.get_height(col) != original.get_height(col)) {
+			return fail("Key constructor failed to initialise heights.");
+		}
+		for (int row = 0; row<test.HEIGHT; row++) {
+			if (rebuilt.get_board(col, row) != original.get_board(col, row)) {
+				return fail("Key constructor failed to initialise board.");
+			}
+		}
+	}
+
+	// Keys that cannot come from a game should throw errors
+	try {
+		test = Position(uint64_t(0));
+		return fail("Key constructor did not throw an error for an empty column.");
+	}
+	catch (...) {}
+	try {
+		// One piece of the current player in the first column, which cannot
+		// happen as the opponent moved first
+		test = Position(Position().get_key() + 2);
+		return fail("Key constructor did not throw an error for unbalanced piece counts.");
+	}
+	catch (...) {}
+
+	// Test the get_threats() method
+	test = Position("33445");
+	/*
+	 * | | | | | | | |
+	 * | | | | | | | |
+	 * | | | | | | | |
+	 * | | | | | | | |
+	 * | | |+|+| | | |
+	 * | | |-|-|-| | |
+	 */
+	// The opponent (first player) threatens both ends of the bottom row
+	uint64_t bottom_left = UINT64_C(1) << (1 * (test.HEIGHT + 1));
+	uint64_t bottom_right = UINT64_C(1) << (5 * (test.HEIGHT + 1));
+	if (test.get_threats(true) != (bottom_left | bottom_right)) {
+		return fail("get_threats() did not find the opponent's threats.");
+	}
+	if (test.get_threats() != 0) {
+		return fail("get_threats() found threats for a player without any.");
+	}
+
+	// Test the get_score_bounds() method
+	int min_score, max_score;
+	// Two playable opponent threats: the current player loses next move
+	test.get_score_bounds(min_score, max_score);
+	if (min_score != -18 || max_score != -18) {
+		return fail("get_score_bounds() did not detect a double threat. (33445)");
+	}
+	// A playable threat of the current player: immediate win
+	test = Position("334455");
+	test.get_score_bounds(min_score, max_score);
+	if (min_score != 18 || max_score != 18) {
+		return fail("get_score_bounds() did not detect an immediate win. (334455)");
+	}
+	// Nothing to resolve statically early in the game: the bounds should
+	// only rule out the quickest wins and losses
+	test = Position("44");
+	test.get_score_bounds(min_score, max_score);
+	if (min_score != -19 || max_score != 19) {
+		return fail("get_score_bounds() returned wrong bounds for an open position. (44)");
+	}
+
 	// If no errors have been found, test passed!
 	cout << "Test passed!" << endl;
 	return 0;
@@ -0,0 +1,121 @@
+/**
+ * session.cpp
+ * Purpose: Implementation for a class that follows a single game in progress,
+ * re-solving it incrementally as moves are appended.
+ *
+ * @author Yuta Nagano
+ * @version 1.2.3
+ */
+
+#include <stdexcept>
+#include <vector>
+#include "session.hpp"
+
+using namespace std;
+
+// Constructors
+
+Session::Session(bool ponder, size_t table_size, bool huge_pages) : engine(table_size, huge_pages), ponder{ponder} {}
+
+Session::~Session() {
+	stop_pondering();
+}
+
+// Public methods
+
+int Session::query(const string& moves, int& position_counter, vector<int>* pv) {
+	// The background thread shares the engine and the score table, so it must
+	// be finished before we touch either
+	stop_pondering();
+
+	// Play the new moves on a copy, so that an invalid move leaves the
+	// session as it was: only the appended moves if the game continues,
+	// otherwise the whole game
+	bool continues = moves.compare(0, history.length(), history) == 0;
+	Position next = continues ? position : Position();
+	for (size_t i = continues ? history.length() : 0; i < moves.length(); i++) {
+		int move = moves[i] - '0' - 1;
+		if (move < 0 || move >= Position::WIDTH || !next.can_play(move)) {
+			if (ponder) start_pondering();
+			throw runtime_error("Session received an invalid move.");
+		}
+		next.play(move);
+	}
+
+	// A new game has started: forget the old one
+	if (!continues) scores.clear();
+	position = next;
+	history = moves;
+
+	int score = lookup_or_solve(position, position_counter, pv);
+
+	if (ponder) start_pondering();
+
+	return score;
+}
+
+const Position& Session::get_position() const {
+	return position;
+}
+
+const Engine& Session::get_engine() const {
+	return engine;
+}
+
+// Private methods
+
+int Session::lookup_or_solve(const Position& P, int& position_counter, vector<int>* pv) {
+	auto found = scores.find(P.get_key());
+	if (found != scores.end()) {
+		if (!pv) return found->second;
+		// Pondering leaves the table full of the entries needed to rebuild
+		// the line, unless they have been replaced since
+		if (engine.reconstruct_variation(P, found->second, *pv)) return found->second;
+	}
+
+	int score = engine.solve(P, position_counter);
+	if (!engine.is_stopped()) {
+		scores[P.get_key()] = score;
+		if (pv) *pv = engine.get_principal_variation();
+	}
+	return score;
+}
+
+void Session::start_pondering() {
+	engine.resume();
+	ponderer = thread(&Session::ponder_positions, this);
+}
+
+void Session::stop_pondering() {
+	if (!ponderer.joinable()) return;
+	engine.stop();
+	ponderer.join();
+	engine.resume();
+}
+
+void Session::ponder_positions() {
+	// Positions to solve at the current and next depth, expanded breadth
+	// first so that the likeliest next queries are solved first
+	vector<Position> frontier{position}, next;
+	int counter = 0;
+
+	for (int depth = 0; depth < PONDER_DEPTH; depth++) {
+		for (const Position& P : frontier) {
+			for (int i = 0; i < Position::WIDTH; i++) {
+				int move = engine.get_column(i);
+				// Positions where the game has already ended will never be
+				// queried, so don't bother with them
+				if (!P.can_play(move) || P.is_winning_move(move)) continue;
+				Position P2(P);
+				P2.play(move);
+				if (P2.get_moves() == Position::WIDTH * Position::HEIGHT) continue;
+
+				lookup_or_solve(P2, counter);
+				if (engine.is_stopped()) return;
+				next.push_back(P2);
+			}
+		}
+		frontier.swap(next);
+		next.clear();
+	}
+}
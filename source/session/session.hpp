@@ -0,0 +1,118 @@
+/**
+ * session.hpp
+ * Purpose: A definition for a class that follows a single game in progress,
+ * re-solving it incrementally as moves are appended.
+ *
+ * @author Yuta Nagano
+ * @version 1.2.3
+ */
+
+#ifndef SESSION_HEADER
+#define SESSION_HEADER
+
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+#include <cstdint>
+#include "../position/position.hpp"
+#include "../engine/engine.hpp"
+
+/**
+ * A class following a game in progress. Each query gives the whole game so
+ * far; if it extends the previous query only the new moves are played, and
+ * the scores found by previous queries (and by pondering) are reused, along
+ * with the engine's transposition table.
+ * When pondering is enabled, the positions reachable in the next few moves are
+ * solved in a background thread between queries, so that the next query is
+ * usually answered straight from the table.
+ */
+class Session {
+
+	public:
+		/**
+		 * How many moves ahead of the current position to ponder.
+		 */
+		static const int PONDER_DEPTH = 2;
+
+		/**
+		 * Constructor, build a session with no game in progress.
+		 * @param ponder: whether to solve likely future positions in the
+		 *        background between queries
+		 * @param table_size, huge_pages: transposition table settings for the
+		 *        session's engine (see Engine)
+		 */
+		Session(bool ponder = false, size_t table_size = TranspositionTable::DEFAULT_SIZE, bool huge_pages = false);
+
+		/**
+		 * Destructor, stops any pondering before the session goes away.
+		 */
+		~Session();
+
+		Session(const Session&) = delete;
+		Session& operator=(const Session&) = delete;
+
+		/**
+		 * Solve the given game. If the game extends the game given in the
+		 * previous query, only the appended moves are played on the current
+		 * position, otherwise a new game is started.
+		 * Throws a runtime error if the moves are not valid, in which case
+		 * the session is left as it was before the query.
+		 * @param moves: the game so far in the usual 1-indexed notation
+		 * @param position_counter: incremented for every evaluated position
+		 *        (left untouched if the score was already known)
+		 * @param pv: if given, filled with the principal variation of the
+		 *        position as 0-based columns (see Engine)
+		 * @return the exact score of the position
+		 */
+		int query(const string& moves, int& position_counter, std::vector<int>* pv = nullptr);
+
+		/**
+		 * @return the position reached by the last query
+		 */
+		const Position& get_position() const;
+
+		/**
+		 * @return the engine used by the session
+		 */
+		const Engine& get_engine() const;
+
+	private:
+		Engine engine;
+		Position position;
+		string history;
+		bool ponder;
+		std::thread ponderer;
+
+		/**
+		 * Exact scores found so far, by position key.
+		 */
+		std::unordered_map<uint64_t, int> scores;
+
+		/**
+		 * Look up the score of a position, solving it if it is unknown (or if
+		 * a principal variation is asked for and the transposition table no
+		 * longer holds all of it). Scores from interrupted searches are not
+		 * stored.
+		 */
+		int lookup_or_solve(const Position& P, int& position_counter, std::vector<int>* pv = nullptr);
+
+		/**
+		 * Start solving future positions in a background thread.
+		 */
+		void start_pondering();
+
+		/**
+		 * Interrupt the background thread and wait for it to finish.
+		 */
+		void stop_pondering();
+
+		/**
+		 * Body of the background thread: solve every position reachable from
+		 * the current one within PONDER_DEPTH moves, nearest first.
+		 */
+		void ponder_positions();
+
+};
+
+#endif
@@ -0,0 +1,124 @@
+/**
+ * session_tester.cpp
+ * Purpose: Unit test for the session class.
+ *
+ * @author Yuta Nagano
+ * @version 1.0.0
+ */
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <stdexcept>
+#include "session.hpp"
+
+using namespace std;
+
+int fail(string msg);
+
+/**
+ * @return the score of a game, solved from scratch by a separate engine
+ */
+int solve(Engine& engine, const string& moves);
+
+/**
+ * @return the game followed by the first move that can be played without
+ *         ending it
+ */
+string extend(const string& moves);
+
+int main() {
+	// A small table is enough for positions this deep
+	const size_t table_size = size_t(16) << 20;
+	Engine engine(table_size);
+	int counter = 0;
+
+	// Position taken from test_sets/Test_L3_R1, with a score of -1
+	string game = "2252576253462244111563365343671351441";
+	Position P(game);
+
+	// Find a full column
+	char full = 0;
+	for (int col = 0; col < Position::WIDTH; col++)
+		if (!P.can_play(col)) full = char('1' + col);
+	if (!full) return fail("Test position does not have a full column.");
+	string extended = extend(game);
+
+	for (bool ponder : {false, true}) {
+		Session test(ponder, table_size);
+
+		// Test that a new game is solved correctly
+		if (test.query(game, counter) != -1) {
+			return fail("query() returned a wrong score for a new game.");
+		}
+
+		// Test that extending the game plays the appended move
+		if (test.query(extended, counter) != solve(engine, extended)) {
+			return fail("query() returned a wrong score for an extended game.");
+		}
+		if (test.get_position().get_key() != Position(extended).get_key()) {
+			return fail("query() did not play the appended move.");
+		}
+
+		// Test that an invalid appended move throws, without playing the
+		// valid moves before it, in a full column and in a missing column
+		for (string bad : {string(1, full), string("8"), string("0")}) {
+			try {
+				test.query(extend(extend(extended)) + bad, counter);
+				return fail("query() did not throw on an invalid move.");
+			}
+			catch (const runtime_error&) {}
+			if (test.get_position().get_key() != Position(extended).get_key()) {
+				return fail("query() changed the position before throwing.");
+			}
+		}
+
+		// Test that the session carries on from where it was
+		string next = extend(extended);
+		if (test.query(next, counter) != solve(engine, next)) {
+			return fail("query() returned a wrong score after an invalid move.");
+		}
+
+		// Test that a game that does not extend the previous one starts over,
+		// and that an invalid new game is rejected as a whole
+		try {
+			test.query("44449", counter);
+			return fail("query() did not throw on an invalid new game.");
+		}
+		catch (const runtime_error&) {}
+		if (test.get_position().get_key() != Position(next).get_key()) {
+			return fail("query() changed the position before rejecting a new game.");
+		}
+		if (test.query(game, counter) != -1 || test.get_position().get_key() != P.get_key()) {
+			return fail("query() did not start a new game.");
+		}
+
+		// Test that the principal variation starts from the queried position
+		vector<int> pv;
+		test.query(extended, counter, &pv);
+		if (pv.empty() || !Position(extended).can_play(pv[0])) {
+			return fail("query() did not give a principal variation.");
+		}
+	}
+
+	// If no errors have been found, test passed!
+	cout << "Test passed!" << endl;
+	return 0;
+}
+
+int solve(Engine& engine, const string& moves) {
+	int counter = 0;
+	return engine.solve(Position(moves), counter);
+}
+
+string extend(const string& moves) {
+	Position P(moves);
+	for (int col = 0; col < Position::WIDTH; col++)
+		if (P.can_play(col) && !P.is_winning_move(col)) return moves + char('1' + col);
+	throw runtime_error("extend() was given a game that cannot be continued.");
+}
+
+int fail(string msg) {
+	cout << "Test failed: " << msg << endl;
+	return 1;
+}
@@ -0,0 +1,285 @@
+/**
+	sharder.cpp
+	Purpose:	to solve a large file of positions with several solver processes
+				at once. The input is split into shards, one solver worker is run
+				per shard (reading the shard from its standard input, see
+				solver.cpp), and the workers' outputs are merged back into the
+				original order, so that the result can be checked with the
+				benchmarker as if a single solver had produced it.
+
+	Usage: sharder <solver> <input> <output> <shards> [--prefix K] [-- solver options]
+	- solver: path to the solver executable
+	- input: one position per line; anything after the first space (e.g. the
+	  scores in a test set) is ignored. Blank lines are rejected, as the
+	  solver would take them for the empty board.
+	- output: where to write the merged solver output
+	- shards: number of worker processes to run
+	- --prefix K: shard by opening instead of by line range. Positions sharing
+	  their first K moves go to the same shard, so that they can share the
+	  worker's transposition table. Groups are handed out largest first to the
+	  least loaded shard.
+	- anything after "--" is passed on to every worker.
+
+	Temporary files <output>.shard<i>.in and <output>.shard<i>.out are created
+	next to the output, and removed once merged. Per-shard line counts, wall
+	times and throughputs are printed on completion, along with the imbalance
+	between shards (slowest shard time over mean shard time).
+
+	@author Yuta Nagano
+	@version 1.0.1
+*/
+
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <stdexcept>
+#include <vector>
+#include <map>
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/wait.h>
+
+using namespace std;
+using namespace std::chrono;
+
+/**
+ * A shard of the input: the (0-based) input line numbers it holds, in input
+ * order, and the worker solving it.
+ */
+struct Shard {
+	vector<size_t> lines;
+	string input_path, output_path;
+	pid_t pid;
+	steady_clock::time_point start, stop;
+	unsigned long long solver_mics;
+};
+
+bool parse_int(const string& arg, int& value);
+int read_positions(string fname, vector<string>& positions);
+void split_by_range(size_t n_positions, vector<Shard>& shards);
+void split_by_prefix(const vector<string>& positions, int prefix_length, vector<Shard>& shards);
+int write_shard_inputs(const vector<string>& positions, vector<Shard>& shards);
+int run_workers(string solver, const vector<string>& solver_args, vector<Shard>& shards);
+int merge_outputs(string fname, size_t n_positions, vector<Shard>& shards);
+void report(const vector<Shard>& shards);
+
+int main(int argc, char* argv[]) {
+	// Split the arguments into our own and the ones meant for the workers
+	vector<string> args, solver_args;
+	int i = 1;
+	for (; i < argc && string(argv[i]) != "--"; i++) args.push_back(argv[i]);
+	for (i++; i < argc; i++) solver_args.push_back(argv[i]);
+
+	int prefix_length = -1, n_shards = 0;
+	bool valid = true;
+	if (args.size() == 6 && args[4] == "--prefix") {
+		valid = parse_int(args[5], prefix_length);
+		prefix_length = max(prefix_length, 0);
+		args.resize(4);
+	}
+	if (!valid || args.size() != 4 || !parse_int(args[3], n_shards) || n_shards < 1) {
+		cout << "Error: bad arguments." << endl;
+		cout << "Usage: sharder <solver> <input> <output> <shards> [--prefix K] [-- solver options]" << endl;
+		return 1;
+	}
+
+	vector<string> positions;
+	if (read_positions(args[1], positions)) return 1;
+
+	vector<Shard> shards(n_shards);
+	for (size_t s = 0; s < shards.size(); s++) {
+		shards[s].input_path = args[2] + ".shard" + to_string(s) + ".in";
+		shards[s].output_path = args[2] + ".shard" + to_string(s) + ".out";
+	}
+
+	if (prefix_length < 0) split_by_range(positions.size(), shards);
+	else split_by_prefix(positions, prefix_length, shards);
+
+	if (write_shard_inputs(positions, shards)) return 1;
+	if (run_workers(args[0], solver_args, shards)) return 1;
+	if (merge_outputs(args[2], positions.size(), shards)) return 1;
+
+	// The shard files are only removed on success, to help debug failures
+	for (const Shard& shard : shards) {
+		remove(shard.input_path.c_str());
+		remove(shard.output_path.c_str());
+	}
+
+	report(shards);
+
+	return 0;
+}
+
+bool parse_int(const string& arg, int& value) {
+	size_t length = 0;
+	try {
+		value = stoi(arg, &length);
+	}
+	catch (const logic_error&) {
+		return false;
+	}
+	return length == arg.size();
+}
+
+int read_positions(string fname, vector<string>& positions) {
+	ifstream input(fname);
+	if (!input.is_open()) {
+		cout << "Error: bad path supplied.\n";
+		return 1;
+	}
+
+	string line, position;
+	for (size_t line_num = 1; getline(input, line); line_num++) {
+		position.clear();
+		istringstream(line) >> position;
+		if (position.empty()) {
+			cout << "Error: blank line " << line_num << " in input.\n";
+			return 1;
+		}
+		positions.push_back(position);
+	}
+
+	return 0;
+}
+
+void split_by_range(size_t n_positions, vector<Shard>& shards) {
+	size_t n_shards = shards.size();
+	for (size_t s = 0; s < n_shards; s++)
+		for (size_t l = s * n_positions / n_shards; l < (s + 1) * n_positions / n_shards; l++)
+			shards[s].lines.push_back(l);
+}
+
+void split_by_prefix(const vector<string>& positions, int prefix_length, vector<Shard>& shards) {
+	// Group the lines by opening
+	map<string, vector<size_t>> groups;
+	for (size_t l = 0; l < positions.size(); l++)
+		groups[positions[l].substr(0, prefix_length)].push_back(l);
+
+	// Hand out the largest groups first, each to the shard with the fewest
+	// lines so far
+	vector<const vector<size_t>*> order;
+	for (const auto& group : groups) order.push_back(&group.second);
+	stable_sort(order.begin(), order.end(), [](const vector<size_t>* a, const vector<size_t>* b) {
+		return a->size() > b->size();
+	});
+
+	for (const vector<size_t>* group : order) {
+		Shard& target = *min_element(shards.begin(), shards.end(), [](const Shard& a, const Shard& b) {
+			return a.lines.size() < b.lines.size();
+		});
+		target.lines.insert(target.lines.end(), group->begin(), group->end());
+	}
+
+	// Keep each shard in input order
+	for (Shard& shard : shards) sort(shard.lines.begin(), shard.lines.end());
+}
+
+int write_shard_inputs(const vector<string>& positions, vector<Shard>& shards) {
+	for (Shard& shard : shards) {
+		ofstream out(shard.input_path);
+		for (size_t l : shard.lines) out << positions[l] << '\n';
+		if (!out) {
+			cout << "Error: could not write " << shard.input_path << endl;
+			return 1;
+		}
+	}
+
+	return 0;
+}
+
+int run_workers(string solver, const vector<string>& solver_args, vector<Shard>& shards) {
+	// Build the workers' argv once, it is the same for all of them
+	vector<char*> argv;
+	argv.push_back(const_cast<char*>(solver.c_str()));
+	for (const string& arg : solver_args) argv.push_back(const_cast<char*>(arg.c_str()));
+	argv.push_back(nullptr);
+
+	for (Shard& shard : shards) {
+		shard.start = steady_clock::now();
+		shard.pid = fork();
+		if (shard.pid < 0) {
+			cout << "Error: could not start a worker." << endl;
+			return 1;
+		}
+		if (shard.pid == 0) {
+			// Worker: read the shard, write its output, then become the solver
+			int in = open(shard.input_path.c_str(), O_RDONLY);
+			int out = open(shard.output_path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+			if (in < 0 || out < 0 || dup2(in, STDIN_FILENO) < 0 || dup2(out, STDOUT_FILENO) < 0) _exit(127);
+			close(in);
+			close(out);
+			execv(argv[0], argv.data());
+			_exit(127);
+		}
+	}
+
+	// Wait for every worker, noting when each one finishes
+	int failures = 0;
+	for (size_t done = 0; done < shards.size(); done++) {
+		int status;
+		pid_t pid = wait(&status);
+		for (size_t s = 0; s < shards.size(); s++) {
+			if (shards[s].pid != pid) continue;
+			shards[s].stop = steady_clock::now();
+			if (!WIFEXITED(status) || WEXITSTATUS(status) != 0) {
+				cout << "Error: worker for shard " << s << " failed." << endl;
+				failures++;
+			}
+		}
+	}
+
+	return failures ? 1 : 0;
+}
+
+int merge_outputs(string fname, size_t n_positions, vector<Shard>& shards) {
+	vector<string> merged(n_positions);
+	string line, token;
+
+	for (size_t s = 0; s < shards.size(); s++) {
+		Shard& shard = shards[s];
+		ifstream in(shard.output_path);
+		shard.solver_mics = 0;
+
+		for (size_t l : shard.lines) {
+			if (!getline(in, line)) {
+				cout << "Error: missing lines in output of shard " << s << endl;
+				return 1;
+			}
+			// Add up the solver's own timings (fourth column)
+			istringstream ss(line);
+			for (int t = 0; t < 4 && ss >> token; t++)
+				if (t == 3) shard.solver_mics += stoull(token);
+			merged[l] = line;
+		}
+	}
+
+	ofstream out(fname);
+	for (const string& l : merged) out << l << '\n';
+	if (!out) {
+		cout << "Error: could not write " << fname << endl;
+		return 1;
+	}
+
+	return 0;
+}
+
+void report(const vector<Shard>& shards) {
+	double total = 0, slowest = 0;
+
+	cout << "shard lines wall_s positions_per_s solver_s" << endl;
+	for (size_t s = 0; s < shards.size(); s++) {
+		double wall = duration<double>(shards[s].stop - shards[s].start).count();
+		total += wall;
+		slowest = max(slowest, wall);
+		cout << s << " " << shards[s].lines.size() << " " << wall << " " << \
+			(wall > 0 ? shards[s].lines.size() / wall : 0) << " " << \
+			shards[s].solver_mics / 1e6 << endl;
+	}
+
+	double mean = total / shards.size();
+	cout << "Imbalance (slowest / mean shard time): " << (mean > 0 ? slowest / mean : 1) << endl;
+}
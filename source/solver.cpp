@@ -6,6 +6,35 @@
  * - standard output: space separated position, score, number of explored nodes, 
  *   computation time in microseconds.
  *
+ * Options:
+ * --session: treat the input as a single game in progress. Each line should
+ *   repeat the previous line with the latest moves appended (e.g. 4453, then
+ *   44536); only the new moves are played, and scores already found are reused.
+ *   A line that does not extend the previous one starts a new game.
+ * --ponder: as --session, but also solve the likely next positions in the
+ *   background while waiting for the next line.
+ * --perf: also output hardware performance counters measured over the same
+ *   work as the computation time (the search, and the principal variation
+ *   with --pv), as five extra columns following the computation time: cycles,
+ *   instructions, branch misses, L1 data cache read misses and last level
+ *   cache read misses. Counters the system does not allow are printed as "-".
+ * --pv: also output the best move and the principal variation (the line of
+ *   play where both sides play perfectly, to the end of the game) as two
+ *   extra columns, in the same notation as the input (after the counters,
+ *   with --perf). Both come out of the same search as the score. In session
+ *   mode, a line for a score that is already known is rebuilt from the
+ *   transposition table, and the position is solved again (and counted)
+ *   only if the table no longer holds all of it. "-" is printed for a
+ *   finished game.
+ * --table-mb N: use N megabytes for the transposition table (default 64).
+ * --huge-pages: try to back the transposition table with 2MB huge pages,
+ *   falling back to regular pages if none are available.
+ * The transposition table's footprint is printed to the standard error on
+ * startup.
+ * --stats: once all lines are read, print search statistics (total explored
+ *   nodes, and the share of beta cutoffs caused by the first explored child) to
+ *   the standard error.
+ *
  * Position notation: a string of numbers corresponding to the played columns.
  * E.g. 4453:
  * | | | | | | | |
@@ -16,7 +45,7 @@
  * | | |2|1|1| | |
  *
  * @author: Yuta Nagano
- * @version: 1.2.0
+ * @version: 1.6.3
  */
 
 #include <iostream>
@@ -25,87 +54,133 @@
 #include <chrono>
 #include <algorithm>
 #include <cctype>
+#include <memory>
+#include <vector>
 #include "position/position.hpp"
+#include "engine/engine.hpp"
+#include "perf/perf_counters.hpp"
+#include "session/session.hpp"
 
 using namespace std;
 using namespace std::chrono;
 
-/**
- * This variable will contain column values in the order that they should be
- * explored (from the centre columns). The values will be initialised properly
- * within the main function.
- */
-int columnOrder[Position::WIDTH];
-
 /**
  * Checks if a given line (string) contains only digit chars.
  * @return 1 if string contains only digits, 0 otherwise
  */
 int only_digits(const string& line);
 
-/**
- * Recursively solve a connect4 position using the negamax variant of the
- * minimax algorithm with alpha-beta pruning. A reference to an int counter
- * should be passed in, which will be incremented every time a new position is 
- * evaluated in the recursive algorithm.
- * @param alpha, the lower bound for the window in which we search for the
- *        score, which also represents the best score reached upstream so far
- *        by the maximiser.
- * @param beta, the upper bound for the window in which we search for the score,
- *        which also represents the best score reached upstream so far by the
- *        minimiser.
- * @return the exact score, or an upper or lower bound of the socre of a
- *         position depending on the case:
- *  - if alpha <= actual score <= beta, then return true score
- *  - if actual score <= alpha, then return upper bound of actual score
- *  - if actual score >= beta, then return lower bound of actual score
- *  - the scores will take the following values:
- *		- 0 for a draw
- *		- positive score for a forcing win, where the numerical value
- *		  corresponds to the number of turns before the maximum possible turns
- *		  that you win (that is, the earlier you win, the higher your score)
- *		- negative score for a forcing loss, where the numerical value
- *		  corresponds to the number of turns before the maximum possible turns
- *		  that you lose (that is, the earlier you lose, the lower your score)
- */
-int negamax(const Position& P, int alpha, int beta, int& position_counter);
-
 /**
  * read every line from the standard input, which should contain an encoding
  * of a connect4 position (read above for the position encoding syntax), evaluate
  * that position, and return that position's score, number of evaluated positions,
  * and computation time in microseconds.
  */
-int main() {
-	// Initialise the values within the columnOrder array.
-	for (int i = 0; i < Position::WIDTH; i++)
-		columnOrder[i] = Position::WIDTH/2 + (i+1)/2 * (1-2*(i%2));
+int main(int argc, char* argv[]) {
+	// Read the options (see above)
+	bool session_mode = false, ponder = false, stats = false, huge_pages = false, show_pv = false, show_perf = false;
+	size_t table_size = TranspositionTable::DEFAULT_SIZE;
+	for (int i = 1; i < argc; i++) {
+		string arg = argv[i];
+		if (arg == "--session") session_mode = true;
+		else if (arg == "--ponder") session_mode = ponder = true;
+		else if (arg == "--stats") stats = true;
+		else if (arg == "--pv") show_pv = true;
+		else if (arg == "--perf") show_perf = true;
+		else if (arg == "--huge-pages") huge_pages = true;
+		else if (arg == "--table-mb" && i + 1 < argc) table_size = stoull(argv[++i]) << 20;
+		else throw runtime_error("Unrecognised option: " + arg);
+	}
+
+	// Only build what the chosen mode needs, as each owns a transposition table
+	unique_ptr<Engine> engine;
+	unique_ptr<Session> session;
+	if (session_mode) session.reset(new Session(ponder, table_size, huge_pages));
+	else engine.reset(new Engine(table_size, huge_pages));
+
+	const TranspositionTable& table = session_mode ? session->get_engine().get_table() : engine->get_table();
+	cerr << "Transposition table: " << (table.get_size() >> 20) << " MB (" << \
+		table.get_buckets() << " buckets of " << TranspositionTable::ENTRIES_PER_BUCKET << \
+		" entries, " << (table.has_huge_pages() ? "huge" : "regular") << " pages)" << endl;
+
+	// Open the performance counters only if asked, and say so if there are
+	// none to be had rather than failing
+	unique_ptr<PerfCounters> perf;
+	if (show_perf) {
+		perf.reset(new PerfCounters());
+		if (!perf->any_available())
+			cerr << "Warning: hardware performance counters are unavailable." << endl;
+	}
 
 	// Declare a string to store the read lines in, a position object to store
 	// positions in, and ints for the score and a counter to track the number
 	// of positions explored
 	string line;
 	Position position;
-	int score, counter, baseScore = Position::WIDTH * Position::HEIGHT / 2;
+	int score, counter;
+	vector<int> pv;
+	unsigned long long total_nodes = 0, cutoffs = 0, first_child_cutoffs = 0;
 
 	while (getline(cin, line)) {
 		if (!only_digits(line))
 			throw runtime_error("Input contains lines with non-digit charcters.");
 		counter = 0;
-		position = Position(line);
 
-		// take a note of the time to measure execution time in microseconds
+		// take a note of the time to measure execution time in microseconds,
+		// inside the counters' window so that enabling and disabling them
+		// (a few syscalls) is not timed
+		if (perf) perf->start();
 		high_resolution_clock::time_point start = high_resolution_clock::now();
 
-		score = negamax(position, -baseScore, baseScore, counter);
+		if (session_mode) {
+			score = session->query(line, counter, show_pv ? &pv : nullptr);
+		}
+		else {
+			position = Position(line);
+			score = engine->solve(position, counter);
+			if (show_pv) pv = engine->get_principal_variation();
+		}
 
 		// now take note of the time again
 		high_resolution_clock::time_point stop = high_resolution_clock::now();
+		if (perf) perf->stop();
+
+		if (!session_mode) {
+			cutoffs += engine->get_context().cutoffs;
+			first_child_cutoffs += engine->get_context().first_child_cutoffs;
+		}
 
 		// calculate the time taken for execution
 		microseconds duration = chrono::duration_cast<microseconds>(stop - start);
 
-		cout << line << " " << score << " " << counter << " " << duration.count() << endl;
+		cout << line << " " << score << " " << counter << " " << duration.count();
+		if (perf) {
+			for (int i = 0; i < PerfCounters::N_COUNTERS; i++) {
+				PerfCounters::Counter c = PerfCounters::Counter(i);
+				if (perf->is_available(c)) cout << " " << perf->get(c);
+				else cout << " -";
+			}
+		}
+		if (show_pv) {
+			if (pv.empty()) {
+				cout << " - -";
+			}
+			else {
+				cout << " " << pv[0] + 1 << " ";
+				for (int move : pv) cout << move + 1;
+			}
+		}
+		cout << endl;
+		total_nodes += counter;
+	}
+
+	if (stats) {
+		cerr << "Total # of nodes explored: " << total_nodes << endl;
+		if (!session_mode) {
+			cerr << "Beta cutoffs: " << cutoffs << " (" << \
+				(cutoffs ? 100.0 * first_child_cutoffs / cutoffs : 0.0) << \
+				"% on the first child)" << endl;
+		}
 	}
 
 	return 0;
@@ -114,55 +189,3 @@ int main() {
 int only_digits(const string& line) {
 	return all_of(line.begin(), line.end(), ::isdigit);
 }
-
-int negamax(const Position& P, int alpha, int beta, int& position_counter) {
-	// Increment the position counter as we are evaluating a new position
-	position_counter++;
-
-	// Check for a draw, and return 0 if the case
-	if (P.get_moves() == Position::WIDTH * Position::HEIGHT) return 0;
-
-	// Check if current player can win in the next move, and return appropriate
-	// score if the case
-	for (int i = 0; i < Position::WIDTH; i++)
-		if (P.can_play(i) && P.is_winning_move(i))
-			return (Position::WIDTH * Position::HEIGHT - P.get_moves() + 1) / 2;
-
-	// Otherwise, recursively evaluate future positions via negamax and use
-	// those evaluations to compute the value of the current position
-	
-	// Upper bound the max possible score, given that we cannot win immediately
-	int maxScore = (Position::WIDTH * Position::HEIGHT - P.get_moves() - 1) / 2;
-	
-	// Beta does not need to be larger than maxScore
-	if (beta > maxScore) {
-		beta = maxScore;
-		// Prune exploration if the [alpha:beta] window is now empty
-		if (alpha >= beta) return beta;
-	}
-
-	// Evaluate the scores of all possible next positions and keep the best one
-	for (int i = 0; i < Position::WIDTH; i++) {
-		int move = columnOrder[i];
-		if (P.can_play(move)) {
-			// Create a copy of the curent position
-			Position P2(P);
-			// Use this copy to play the potential move
-			P2.play(move);
-			// Evaluate the position (negative score because the "current player"
-			// in this position would be the opponent of the current player of
-			// the current position being evaluated. Notice also that the alpha
-			// and beta are inverted and fed in in the opposite order.)
-			int score = -negamax(P2, -beta, -alpha, position_counter);
-			// Prune the exploration if we find a move better than what our
-			// opponent will allow (beta)
-			if (score >= beta) return score;
-			// Reduce the [alpha:beta] window for subsequent exploration if we
-			// find current_alpha < score < beta.
-			if (score > alpha) alpha = score;
-		}
-	}
-
-	// Return the minimum guaranteed score
-	return alpha;
-}
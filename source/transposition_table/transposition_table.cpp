@@ -0,0 +1,126 @@
+/**
+ * transposition_table.cpp
+ * Purpose: Implementation for a class caching score bounds of Connect 4
+ * positions by their keys.
+ *
+ * @author Yuta Nagano
+ * @version 1.0.0
+ */
+
+#include <new>
+#include <cstring>
+#include <sys/mman.h>
+#include "transposition_table.hpp"
+
+using namespace std;
+
+static const int KEY_BITS = 49;
+static const int SCORE_SHIFT = KEY_BITS;
+static const int BOUND_SHIFT = SCORE_SHIFT + 7;
+static const int DEPTH_SHIFT = BOUND_SHIFT + 2;
+static const uint64_t KEY_MASK = (UINT64_C(1) << KEY_BITS) - 1;
+
+static const size_t HUGE_PAGE = size_t(2) << 20;
+
+// Constructors
+
+TranspositionTable::TranspositionTable(size_t size, bool huge_pages) : huge{false} {
+	n_buckets = size / sizeof(Bucket);
+	if (n_buckets == 0) n_buckets = 1;
+	allocated = n_buckets * sizeof(Bucket);
+
+	// Anonymous mappings come zeroed, and pages are only backed by memory once
+	// they are touched, so even a large table is cheap to create
+	void* memory = MAP_FAILED;
+	if (huge_pages) {
+		// Huge pages must be allocated whole
+		size_t rounded = (allocated + HUGE_PAGE - 1) / HUGE_PAGE * HUGE_PAGE;
+#ifdef MAP_HUGETLB
+		memory = mmap(nullptr, rounded, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+#endif
+		if (memory != MAP_FAILED) {
+			huge = true;
+			allocated = rounded;
+		}
+	}
+	if (memory == MAP_FAILED) {
+		memory = mmap(nullptr, allocated, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+		if (memory == MAP_FAILED) throw bad_alloc();
+#ifdef MADV_HUGEPAGE
+		// No reserved huge pages: fall back to asking for transparent ones,
+		// which the kernel may or may not grant
+		if (huge_pages) madvise(memory, allocated, MADV_HUGEPAGE);
+#endif
+	}
+
+	buckets = static_cast<Bucket*>(memory);
+}
+
+TranspositionTable::~TranspositionTable() {
+	munmap(buckets, allocated);
+}
+
+// Public methods
+
+void TranspositionTable::put(uint64_t key, int score, Bound bound, int depth) {
+	Bucket& bucket = bucket_of(key);
+	Entry entry = key | uint64_t(score + 64) << SCORE_SHIFT | \
+		uint64_t(bound) << BOUND_SHIFT | uint64_t(depth) << DEPTH_SHIFT;
+
+	// Use the slot already holding this key if there is one, otherwise an
+	// empty slot, otherwise the slot with the shallowest entry
+	int victim = 0;
+	for (int i = 0; i < ENTRIES_PER_BUCKET; i++) {
+		Entry old = bucket.entries[i];
+		if ((old & KEY_MASK) == key || old == 0) {
+			victim = i;
+			break;
+		}
+		if ((old >> DEPTH_SHIFT) < (bucket.entries[victim] >> DEPTH_SHIFT)) victim = i;
+	}
+
+	bucket.entries[victim] = entry;
+}
+
+TranspositionTable::Bound TranspositionTable::get(uint64_t key, int& score) const {
+	const Bucket& bucket = bucket_of(key);
+
+	for (int i = 0; i < ENTRIES_PER_BUCKET; i++) {
+		Entry entry = bucket.entries[i];
+		if ((entry & KEY_MASK) == key) {
+			score = int((entry >> SCORE_SHIFT) & 0x7F) - 64;
+			return Bound((entry >> BOUND_SHIFT) & 0x3);
+		}
+	}
+
+	return NONE;
+}
+
+void TranspositionTable::prefetch(uint64_t key) const {
+	__builtin_prefetch(&bucket_of(key));
+}
+
+void TranspositionTable::clear() {
+	memset(buckets, 0, n_buckets * sizeof(Bucket));
+}
+
+size_t TranspositionTable::get_size() const {
+	return allocated;
+}
+
+size_t TranspositionTable::get_buckets() const {
+	return n_buckets;
+}
+
+bool TranspositionTable::has_huge_pages() const {
+	return huge;
+}
+
+// Private methods
+
+TranspositionTable::Bucket& TranspositionTable::bucket_of(uint64_t key) const {
+	// Scramble the key, then map it onto [0, n_buckets) with a multiply
+	// rather than a (much slower) modulo
+	uint64_t hash = key * UINT64_C(0x9E3779B97F4A7C15);
+	return buckets[(unsigned __int128)hash * n_buckets >> 64];
+}
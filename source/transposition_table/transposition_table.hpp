@@ -0,0 +1,124 @@
+/**
+ * transposition_table.hpp
+ * Purpose: A definition for a class caching score bounds of Connect 4
+ * positions by their keys.
+ *
+ * @author Yuta Nagano
+ * @version 1.0.0
+ */
+
+#ifndef TRANSPOSITION_TABLE_HEADER
+#define TRANSPOSITION_TABLE_HEADER
+
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * A fixed size cache of score bounds indexed by position key (see
+ * Position::get_key()). Entries are grouped into buckets of one cache line
+ * each, so that a probe touches a single line of memory. When a bucket is full,
+ * the entry with the smallest depth (number of moves left to play, i.e. the
+ * smallest subtree) is replaced.
+ * The memory can optionally be backed by 2MB huge pages to cut down on TLB
+ * misses; if the system cannot provide them, regular pages are used instead.
+ */
+class TranspositionTable {
+
+	public:
+		/**
+		 * Kinds of score stored in an entry.
+		 */
+		enum Bound {NONE = 0, LOWER = 1, UPPER = 2, EXACT = 3};
+
+		static const int CACHE_LINE = 64;
+		static const int ENTRIES_PER_BUCKET = 8;
+
+		/**
+		 * Default size of a table, in bytes.
+		 */
+		static const size_t DEFAULT_SIZE = size_t(64) << 20;
+
+		/**
+		 * Constructor, allocate a zeroed table.
+		 * @param size: the memory to use in bytes, rounded down to a whole
+		 *        number of buckets (at least one)
+		 * @param huge_pages: whether to try to allocate the table on huge pages
+		 */
+		TranspositionTable(size_t size = DEFAULT_SIZE, bool huge_pages = false);
+
+		~TranspositionTable();
+
+		TranspositionTable(const TranspositionTable&) = delete;
+		TranspositionTable& operator=(const TranspositionTable&) = delete;
+
+		/**
+		 * Store a score bound for a position, replacing any previous entry for
+		 * the same position.
+		 * @param key: the position key (non-zero, at most 49 bits)
+		 * @param score: the score, between -64 and 63
+		 * @param bound: whether the score is a lower bound, an upper bound or
+		 *        exact
+		 * @param depth: the number of moves left to play in the position
+		 */
+		void put(uint64_t key, int score, Bound bound, int depth);
+
+		/**
+		 * Look up the score bound for a position.
+		 * @return the kind of bound stored (with its value in score), or NONE
+		 *         if the position is not in the table
+		 */
+		Bound get(uint64_t key, int& score) const;
+
+		/**
+		 * Hint that the bucket for a key will be probed soon, so that it can
+		 * be fetched from memory while other work is done.
+		 */
+		void prefetch(uint64_t key) const;
+
+		/**
+		 * Remove all entries.
+		 */
+		void clear();
+
+		/**
+		 * @return the memory taken up by the table, in bytes
+		 */
+		size_t get_size() const;
+
+		/**
+		 * @return the number of buckets in the table
+		 */
+		size_t get_buckets() const;
+
+		/**
+		 * @return true if the table is backed by huge pages
+		 */
+		bool has_huge_pages() const;
+
+	private:
+		/**
+		 * One entry, packed into 64 bits as follows (from the lowest bit):
+		 * - 49 bits: the full position key (0 for an empty entry)
+		 * - 7 bits: the score, offset by 64
+		 * - 2 bits: the bound
+		 * - 6 bits: the depth
+		 */
+		typedef uint64_t Entry;
+
+		struct alignas(CACHE_LINE) Bucket {
+			Entry entries[ENTRIES_PER_BUCKET];
+		};
+
+		Bucket* buckets;
+		size_t n_buckets;
+		size_t allocated;
+		bool huge;
+
+		/**
+		 * @return the bucket a key belongs to
+		 */
+		Bucket& bucket_of(uint64_t key) const;
+
+};
+
+#endif
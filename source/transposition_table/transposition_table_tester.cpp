@@ -0,0 +1,85 @@
+/**
+ * transposition_table_tester.cpp
+ * Purpose: Unit test for the transposition table class.
+ *
+ * @author Yuta Nagano
+ * @version 1.0.0
+ */
+
+#include <iostream>
+#include <string>
+#include "transposition_table.hpp"
+
+using namespace std;
+
+int fail(string msg);
+
+int main() {
+	int score;
+
+	// Create a table with a single bucket, so that every key collides
+	TranspositionTable test(TranspositionTable::CACHE_LINE);
+
+	if (test.get_buckets() != 1) return fail("Table did not round its size down to one bucket.");
+	if (test.get(1, score) != TranspositionTable::NONE) return fail("New table was not empty.");
+
+	// Test that entries are stored and read back correctly, including
+	// negative scores
+	test.put(1, -5, TranspositionTable::LOWER, 10);
+	test.put(2, 21, TranspositionTable::EXACT, 11);
+	if (test.get(1, score) != TranspositionTable::LOWER || score != -5) {
+		return fail("get() did not return the stored lower bound.");
+	}
+	if (test.get(2, score) != TranspositionTable::EXACT || score != 21) {
+		return fail("get() did not return the stored exact score.");
+	}
+
+	// Test that storing a key again replaces its entry rather than adding one
+	test.put(1, -3, TranspositionTable::UPPER, 10);
+	if (test.get(1, score) != TranspositionTable::UPPER || score != -3) {
+		return fail("put() did not replace the entry for an existing key.");
+	}
+
+	// Fill up the bucket (the shallowest entry has depth 10, key 1)
+	for (int i = 3; i <= TranspositionTable::ENTRIES_PER_BUCKET; i++) {
+		test.put(i, 0, TranspositionTable::EXACT, 10 + i);
+	}
+	for (int i = 1; i <= TranspositionTable::ENTRIES_PER_BUCKET; i++) {
+		if (test.get(i, score) == TranspositionTable::NONE) {
+			return fail("Entry lost before the bucket was full.");
+		}
+	}
+
+	// Test that a new key in a full bucket replaces the shallowest entry
+	test.put(42, 7, TranspositionTable::EXACT, 30);
+	if (test.get(42, score) != TranspositionTable::EXACT || score != 7) {
+		return fail("put() did not store a new key in a full bucket.");
+	}
+	if (test.get(1, score) != TranspositionTable::NONE) {
+		return fail("put() did not replace the shallowest entry in a full bucket.");
+	}
+	if (test.get(2, score) == TranspositionTable::NONE) {
+		return fail("put() replaced a deeper entry in a full bucket.");
+	}
+
+	// Test that clear() empties the table
+	test.clear();
+	if (test.get(42, score) != TranspositionTable::NONE) return fail("clear() did not empty the table.");
+
+	// Test that asking for huge pages always gives a usable table, whether or
+	// not the system has any to give
+	TranspositionTable huge(size_t(4) << 20, true);
+	huge.put(12345, 1, TranspositionTable::EXACT, 1);
+	if (huge.get(12345, score) != TranspositionTable::EXACT || score != 1) {
+		return fail("Table allocated with huge pages requested is not usable.");
+	}
+
+	// If no errors have been found, test passed!
+	cout << "Test passed!" << endl;
+	return 0;
+}
+
+int fail(string msg) {
+	cout << "Test failed: " << msg << endl;
+	return 1;
+}